@@ -0,0 +1,784 @@
+/**
+ * Benchmarks for Ex4
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ *
+ * Usage: ./bench [name|all] [max nodes]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "CompactTree.hpp"
+#include "Complex.hpp"
+#include "Node.hpp"
+#include "Tree.hpp"
+
+using namespace ariel;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double elapsed_ns(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    volatile double sink; // Keeps the optimizer from dropping benchmark loops
+
+    // Complete binary search tree over the keys 0..n-1 whose nodes are allocated
+    // one by one in random order, so neighbours in the tree are far apart in memory
+    struct ScatteredBinaryTree
+    {
+        std::vector<Node<double, 2> *> nodes; // nodes[i] is node i in BFS numbering
+
+        explicit ScatteredBinaryTree(size_t n)
+        {
+            std::vector<size_t> allocationOrder(n);
+            for (size_t i = 0; i < n; ++i)
+                allocationOrder[i] = i;
+            std::shuffle(allocationOrder.begin(), allocationOrder.end(), std::mt19937_64(42));
+
+            nodes.resize(n);
+            for (size_t i : allocationOrder)
+                nodes[i] = new Node<double, 2>(0.0);
+            for (size_t i = 1; i < n; ++i)
+                nodes[(i - 1) / 2]->add_child(nodes[i]);
+        }
+
+        ~ScatteredBinaryTree()
+        {
+            for (auto node : nodes)
+                delete node;
+        }
+
+        // A tree over the scattered nodes, with in-order ranks as values (a search tree)
+        void attach(InlineTree<double> &tree)
+        {
+            tree.add_root(nodes.empty() ? nullptr : nodes[0]);
+            double rank = 0;
+            for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+                *it = rank++;
+        }
+    };
+
+    // Average time of one root-to-leaf search for random keys
+    double descent_ns(InlineTree<double> &tree, const std::vector<double> &keys)
+    {
+        auto start = Clock::now();
+        double found = 0;
+        for (double key : keys)
+        {
+            Node<double, 2> *node = tree.get_root();
+            while (node)
+            {
+                if (key == node->value)
+                {
+                    found += node->value;
+                    break;
+                }
+                size_t side = key < node->value ? 0 : 1;
+                node = node->children.size() > side ? node->children[side] : nullptr;
+            }
+        }
+        sink = found;
+        return elapsed_ns(start) / keys.size();
+    }
+
+    // Root-to-leaf searches: scattered pointer tree vs BFS-frozen vs van Emde Boas-frozen
+    void bench_veb(size_t maxNodes)
+    {
+        std::printf("veb: ns per root-to-leaf search (Node<double, 2>)\n");
+        std::printf("%12s %12s %12s %12s\n", "nodes", "pointer", "bfs", "veb");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            ScatteredBinaryTree scattered(n);
+            InlineTree<double> pointerTree, bfsTree, vebTree;
+            scattered.attach(pointerTree);
+            bfsTree.add_root(pointerTree.get_root());
+            bfsTree.freeze(FreezeLayout::BreadthFirst);
+            vebTree.add_root(pointerTree.get_root());
+            vebTree.freeze(FreezeLayout::VanEmdeBoas);
+
+            std::mt19937_64 rng(7);
+            std::uniform_int_distribution<size_t> pick(0, n - 1);
+            std::vector<double> keys(1000000);
+            for (double &key : keys)
+                key = static_cast<double>(pick(rng));
+
+            double pointerNs = descent_ns(pointerTree, keys);
+            double bfsNs = descent_ns(bfsTree, keys);
+            double vebNs = descent_ns(vebTree, keys);
+            std::printf("%12zu %12.1f %12.1f %12.1f\n", n, pointerNs, bfsNs, vebNs);
+        }
+    }
+
+    // A bulky node value: a complex number plus per-node history
+    struct ComplexPayload
+    {
+        Complex number;
+        double history[14];
+    };
+
+    // Random binary tree shape: node i becomes a child of a random node with a free slot
+    template <typename TreeT>
+    void build_random_binary(TreeT &tree, size_t n)
+    {
+        std::mt19937_64 rng(3);
+        typedef decltype(tree.get_root()) NodePtr;
+        std::vector<NodePtr> open; // Nodes with fewer than two children
+        open.push_back(tree.emplace_root(ComplexPayload{Complex(0, 0), {}}));
+        for (size_t i = 1; i < n; ++i)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(0, open.size() - 1)(rng);
+            NodePtr parent = open[pick];
+            open.push_back(tree.emplace_child(parent, ComplexPayload{Complex(double(i), 0), {}}));
+            if (parent->children.size() == 2)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+    }
+
+    // ns per node of a pre-order walk that reads the topology and one double per node
+    template <typename TreeT>
+    double pre_order_ns(TreeT &tree, size_t n)
+    {
+        auto start = Clock::now();
+        double total = 0;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            total += (*it).number.getReal();
+        sink = total;
+        return elapsed_ns(start) / n;
+    }
+
+    // Node layouts for a bulky value type: pointer nodes vs the CompactTree layouts
+    void bench_layout(size_t maxNodes)
+    {
+        std::printf("layout: ns per node, pre-order walk over Tree<ComplexPayload> (%zu-byte values)\n", sizeof(ComplexPayload));
+        std::printf("%12s %12s %12s %12s %12s %12s\n", "nodes", "Node<T>", "Node<T,2>", "aos", "soa", "hot/cold");
+        size_t limit = std::min<size_t>(maxNodes, 1000000); // Five copies of 128-byte values
+        for (size_t n = 1000; n <= limit; n *= 10)
+        {
+            Tree<ComplexPayload> vectorTree;
+            InlineTree<ComplexPayload> inlineTree;
+            build_random_binary(vectorTree, n);
+            build_random_binary(inlineTree, n);
+            CompactTree<ComplexPayload, 2, ArrayOfStructs> aos(inlineTree);
+            CompactTree<ComplexPayload, 2, StructOfArrays> soa(inlineTree);
+            CompactTree<ComplexPayload, 2, HotColdSplit> hotCold(inlineTree);
+
+            std::printf("%12zu %12.2f %12.2f %12.2f %12.2f %12.2f\n", n, pre_order_ns(vectorTree, n),
+                        pre_order_ns(inlineTree, n), pre_order_ns(aos, n), pre_order_ns(soa, n), pre_order_ns(hotCold, n));
+        }
+    }
+
+    // Many short scans: a pre-order and an in-order walk over each 7-node subtree,
+    // so the cost of starting (and copying) an iterator dominates
+    void bench_short_scans(size_t maxNodes)
+    {
+        std::printf("shortscan: ns per scan of a 7-node subtree (InlineTree<int>)\n");
+        std::printf("%12s %12s %12s %12s\n", "scans", "pre-order", "in-order", "pre it++");
+        size_t scans = std::min<size_t>(maxNodes, 1000000);
+
+        // A spine whose left children are complete 7-node subtrees
+        InlineTree<int> tree;
+        std::vector<Node<int, 2> *> subtrees;
+        Node<int, 2> *spine = tree.emplace_root(0);
+        for (size_t s = 0; s < 1024; ++s)
+        {
+            Node<int, 2> *top = tree.emplace_child(spine, 1);
+            for (int c = 0; c < 2; ++c)
+            {
+                Node<int, 2> *mid = tree.emplace_child(top, 2);
+                tree.emplace_child(mid, 3);
+                tree.emplace_child(mid, 4);
+            }
+            subtrees.push_back(top);
+            spine = tree.emplace_child(spine, 0);
+        }
+
+        long total = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < scans; ++i)
+        {
+            PreOrderIterator<int, Node<int, 2>> it(subtrees[i % subtrees.size()], true), end(nullptr, true);
+            for (int seen = 0; seen < 7 && it != end; ++seen, ++it)
+                total += *it;
+        }
+        double preNs = elapsed_ns(start) / scans;
+
+        start = Clock::now();
+        for (size_t i = 0; i < scans; ++i)
+        {
+            InOrderIterator<int, Node<int, 2>> it(subtrees[i % subtrees.size()], true), end(nullptr, true);
+            for (int seen = 0; seen < 7 && it != end; ++seen, ++it)
+                total += *it;
+        }
+        double inNs = elapsed_ns(start) / scans;
+
+        start = Clock::now();
+        for (size_t i = 0; i < scans; ++i)
+        {
+            PreOrderIterator<int, Node<int, 2>> it(subtrees[i % subtrees.size()], true), end(nullptr, true);
+            for (int seen = 0; seen < 7 && it != end; ++seen)
+                total += *it++;
+        }
+        double postfixNs = elapsed_ns(start) / scans;
+
+        sink = static_cast<double>(total);
+        std::printf("%12zu %12.1f %12.1f %12.1f\n", scans, preNs, inNs, postfixNs);
+    }
+
+    // Random tree with up to 3 children per node, built in the tree's arena
+    void build_random_ternary(Tree<int, 3> &tree, size_t n)
+    {
+        std::mt19937_64 rng(5);
+        std::vector<Node<int> *> open; // Nodes with fewer than three children
+        open.push_back(tree.emplace_root(0));
+        for (size_t i = 1; i < n; ++i)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(0, open.size() - 1)(rng);
+            Node<int> *parent = open[pick];
+            open.push_back(tree.emplace_child(parent, static_cast<int>(i)));
+            if (parent->children.size() == 3)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+    }
+
+    // ns per node of a full walk with the given begin/end iterators
+    template <typename It>
+    double walk_ns(It it, It end, size_t n)
+    {
+        auto start = Clock::now();
+        long total = 0;
+        for (; it != end; ++it)
+            total += *it;
+        sink = static_cast<double>(total);
+        return elapsed_ns(start) / n;
+    }
+
+    // Per-node cost of each traversal over a random 3-ary tree (general-tree code paths)
+    void bench_traversal(size_t maxNodes)
+    {
+        std::printf("traversal: ns per node, full walk of a random Tree<int, 3>\n");
+        std::printf("%12s %12s %12s %12s %12s %12s\n", "nodes", "pre-order", "in-order", "post-order", "dfs", "bfs");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            Tree<int, 3> tree;
+            build_random_ternary(tree, n);
+            double pre = walk_ns(tree.begin_pre_order(), tree.end_pre_order(), n);
+            double in = walk_ns(tree.begin_in_order(), tree.end_in_order(), n);
+            double post = walk_ns(tree.begin_post_order(), tree.end_post_order(), n);
+            double dfs = walk_ns(tree.begin_dfs_scan(), tree.end_dfs_scan(), n);
+            double bfs = walk_ns(tree.begin_bfs_scan(), tree.end_bfs_scan(), n);
+            std::printf("%12zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", n, pre, in, post, dfs, bfs);
+        }
+    }
+
+    // Last 10 in-order values: full forward scan vs reverse iterator from the end
+    void bench_tail(size_t maxNodes)
+    {
+        std::printf("tail: us to read the last 10 in-order values (random ParentTree<int>)\n");
+        std::printf("%12s %12s %12s\n", "nodes", "forward", "reverse");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            ParentTree<int> tree;
+            std::mt19937_64 rng(9);
+            std::vector<Node<int, 2, true> *> open{tree.emplace_root(0)};
+            for (size_t i = 1; i < n; ++i)
+            {
+                size_t pick = std::uniform_int_distribution<size_t>(0, open.size() - 1)(rng);
+                Node<int, 2, true> *parent = open[pick];
+                open.push_back(tree.emplace_child(parent, static_cast<int>(i)));
+                if (parent->children.size() == 2)
+                {
+                    open[pick] = open.back();
+                    open.pop_back();
+                }
+            }
+
+            long total = 0;
+            auto start = Clock::now();
+            std::vector<int> window(10);
+            size_t seen = 0;
+            for (auto it = tree.begin_in_order_stackless(); it != tree.end_in_order_stackless(); ++it)
+                window[seen++ % 10] = *it;
+            total += std::accumulate(window.begin(), window.end(), 0L);
+            double forwardUs = elapsed_ns(start) / 1000;
+
+            start = Clock::now();
+            auto it = tree.rbegin_in_order();
+            for (int i = 0; i < 10 && it != tree.rend_in_order(); ++i, ++it)
+                total += *it;
+            double reverseUs = elapsed_ns(start) / 1000;
+
+            sink = static_cast<double>(total);
+            std::printf("%12zu %12.1f %12.2f\n", n, forwardUs, reverseUs);
+        }
+    }
+
+    // Random binary tree with the values 0..n-1
+    void build_random_binary(Tree<int> &tree, size_t n)
+    {
+        std::mt19937_64 rng(11);
+        std::vector<Node<int> *> open{tree.emplace_root(0)};
+        for (size_t i = 1; i < n; ++i)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(0, open.size() - 1)(rng);
+            Node<int> *parent = open[pick];
+            open.push_back(tree.emplace_child(parent, static_cast<int>(i)));
+            if (parent->children.size() == 2)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+    }
+
+    // Iterator loop in the style of Demo.cpp vs the internal visitor, per traversal
+    void bench_visitor(size_t maxNodes)
+    {
+        std::printf("visitor: ns per node, random Tree<int> (binary), iterator loop / for_each_*\n");
+        std::printf("%12s %16s %16s %16s %16s\n", "nodes", "pre-order", "in-order", "post-order", "bfs");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            Tree<int> tree;
+            build_random_binary(tree, n);
+
+            long total = 0;
+            auto add = [&total](int value) { total += value; };
+            double loop[4], visitor[4];
+            auto start = Clock::now();
+            for (auto node = tree.begin_pre_order(); node != tree.end_pre_order(); ++node)
+                total += *node;
+            loop[0] = elapsed_ns(start) / n;
+            start = Clock::now();
+            for (auto node = tree.begin_in_order(); node != tree.end_in_order(); ++node)
+                total += *node;
+            loop[1] = elapsed_ns(start) / n;
+            start = Clock::now();
+            for (auto node = tree.begin_post_order(); node != tree.end_post_order(); ++node)
+                total += *node;
+            loop[2] = elapsed_ns(start) / n;
+            start = Clock::now();
+            for (auto node = tree.begin_bfs_scan(); node != tree.end_bfs_scan(); ++node)
+                total += *node;
+            loop[3] = elapsed_ns(start) / n;
+
+            start = Clock::now();
+            tree.for_each_pre_order(add);
+            visitor[0] = elapsed_ns(start) / n;
+            start = Clock::now();
+            tree.for_each_in_order(add);
+            visitor[1] = elapsed_ns(start) / n;
+            start = Clock::now();
+            tree.for_each_post_order(add);
+            visitor[2] = elapsed_ns(start) / n;
+            start = Clock::now();
+            tree.for_each_bfs(add);
+            visitor[3] = elapsed_ns(start) / n;
+
+            sink = static_cast<double>(total);
+            std::printf("%12zu", n);
+            for (int i = 0; i < 4; ++i)
+                std::printf("   %6.1f / %5.1f", loop[i], visitor[i]);
+            std::printf("\n");
+        }
+    }
+
+    // Sum of all values: one value per ++ vs blocks of 256 from next_values
+    template <typename It>
+    double batch_ns(It it, size_t n)
+    {
+        std::vector<int> block(256);
+        auto start = Clock::now();
+        long total = 0;
+        size_t filled;
+        while ((filled = it.next_values(std::span<int>(block))) > 0)
+        {
+            for (size_t i = 0; i < filled; ++i)
+                total += block[i];
+        }
+        sink = static_cast<double>(total);
+        return elapsed_ns(start) / n;
+    }
+
+    void bench_batch(size_t maxNodes)
+    {
+        std::printf("batch: ns per node summing values of a random Tree<int, 3>, ++ / next_values(256)\n");
+        std::printf("%12s %16s %16s %16s\n", "nodes", "pre-order", "bfs", "frozen bfs");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            Tree<int, 3> tree;
+            build_random_ternary(tree, n);
+            double pre = walk_ns(tree.begin_pre_order(), tree.end_pre_order(), n);
+            double preBatch = batch_ns(tree.begin_pre_order(), n);
+            double bfs = walk_ns(tree.begin_bfs_scan(), tree.end_bfs_scan(), n);
+            double bfsBatch = batch_ns(tree.begin_bfs_scan(), n);
+            tree.freeze();
+            double frozen = walk_ns(tree.begin_bfs_scan(), tree.end_bfs_scan(), n);
+            double frozenBatch = batch_ns(tree.begin_bfs_scan(), n);
+            std::printf("%12zu   %6.1f / %5.1f   %6.1f / %5.1f   %6.1f / %5.1f\n", n, pre, preBatch, bfs, bfsBatch, frozen, frozenBatch);
+        }
+    }
+
+    // BFS scan with prefetching at several distances (0: off) over a complete
+    // ternary tree whose nodes were allocated one by one in random order
+    void bench_prefetch(size_t maxNodes)
+    {
+        const size_t distances[] = {0, 4, 8, 16};
+        std::printf("prefetch: ns per node of a BFS scan, scattered complete Tree<int, 3>\n");
+        std::printf("%12s %8s %8s %8s %8s\n", "nodes", "off", "d=4", "d=8", "d=16");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            std::vector<size_t> allocationOrder(n);
+            std::iota(allocationOrder.begin(), allocationOrder.end(), 0);
+            std::shuffle(allocationOrder.begin(), allocationOrder.end(), std::mt19937_64(42));
+            std::vector<Node<int> *> nodes(n);
+            for (size_t i : allocationOrder)
+                nodes[i] = new Node<int>(static_cast<int>(i));
+            for (size_t i = 1; i < n; ++i)
+                nodes[(i - 1) / 3]->add_child(nodes[i]);
+
+            // Best of three runs, the timings on a shared machine are noisy
+            Tree<int, 3> tree;
+            tree.add_root(nodes[0]);
+            double best[4];
+            std::fill(best, best + 4, 1e300);
+            for (int run = 0; run < 3; ++run)
+            {
+                for (int i = 0; i < 4; ++i)
+                    best[i] = std::min(best[i], walk_ns(tree.begin_bfs_scan(distances[i]), tree.end_bfs_scan(), n));
+            }
+            std::printf("%12zu %8.1f %8.1f %8.1f %8.1f\n", n, best[0], best[1], best[2], best[3]);
+
+            for (auto node : nodes)
+                delete node;
+        }
+    }
+
+    double generator_ns(Generator<int> generator, size_t n)
+    {
+        auto start = Clock::now();
+        long total = 0;
+        for (int value : generator)
+            total += value;
+        sink = static_cast<double>(total);
+        return elapsed_ns(start) / n;
+    }
+
+    // Iterators vs Tree::traverse() generators: full scans per node, and the cost of
+    // starting a scan and reading its first 8 values (where the frame cache matters)
+    void bench_generator(size_t maxNodes)
+    {
+        std::printf("generator: ns per node, random Tree<int> (binary), iterator / traverse()\n");
+        std::printf("%12s %16s %16s %16s %16s\n", "nodes", "pre-order", "in-order", "post-order", "bfs");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            Tree<int> tree;
+            build_random_binary(tree, n);
+            std::printf("%12zu   %6.1f / %5.1f   %6.1f / %5.1f   %6.1f / %5.1f   %6.1f / %5.1f\n", n,
+                        walk_ns(tree.begin_pre_order(), tree.end_pre_order(), n), generator_ns(tree.traverse(TraversalOrder::PreOrder), n),
+                        walk_ns(tree.begin_in_order(), tree.end_in_order(), n), generator_ns(tree.traverse(TraversalOrder::InOrder), n),
+                        walk_ns(tree.begin_post_order(), tree.end_post_order(), n), generator_ns(tree.traverse(TraversalOrder::PostOrder), n),
+                        walk_ns(tree.begin_bfs_scan(), tree.end_bfs_scan(), n), generator_ns(tree.traverse(TraversalOrder::BreadthFirst), n));
+        }
+
+        const size_t repeats = 1000000;
+        Tree<int> tree;
+        build_random_binary(tree, 1000);
+        long total = 0;
+        auto start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            auto it = tree.begin_in_order();
+            for (int i = 0; i < 8; ++i, ++it)
+                total += *it;
+        }
+        double iteratorStart = elapsed_ns(start) / repeats;
+        size_t freshBefore = FrameCache::local().fresh_allocations();
+        start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            auto generator = tree.traverse(TraversalOrder::InOrder);
+            auto it = generator.begin();
+            for (int i = 0; i < 8; ++i, ++it)
+                total += *it;
+        }
+        double generatorStart = elapsed_ns(start) / repeats;
+        sink = static_cast<double>(total);
+        std::printf("first 8 in-order values: iterator %.1f ns, traverse() %.1f ns, %zu frames allocated in %zu scans\n",
+                    iteratorStart, generatorStart, FrameCache::local().fresh_allocations() - freshBefore, repeats);
+    }
+
+    // Some independent work per node: a few rounds of xorshift on the value
+    inline void scramble(int &value)
+    {
+        unsigned x = static_cast<unsigned>(value) | 1u;
+        for (int round = 0; round < 16; ++round)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+        }
+        value = static_cast<int>(x);
+    }
+
+    // for_each_pre_order vs parallel_for_each with 1, 2, 4 and all hardware threads
+    void bench_parallel(size_t maxNodes)
+    {
+        const size_t threadCounts[] = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+        std::printf("parallel: ms per pass of scramble() over a random Tree<int, 3>, %u hardware threads\n",
+                    std::thread::hardware_concurrency());
+        std::printf("%12s %10s %10s %10s %10s %10s\n", "nodes", "serial", "1 thread", "2", "4", "all");
+        for (size_t n = 100000; n <= maxNodes; n *= 10)
+        {
+            Tree<int, 3> tree;
+            build_random_ternary(tree, n);
+
+            auto start = Clock::now();
+            tree.for_each_pre_order([](int &value) { scramble(value); });
+            std::printf("%12zu %10.1f", n, elapsed_ns(start) / 1e6);
+            for (size_t threads : threadCounts)
+            {
+                ThreadPool pool(threads);
+                start = Clock::now();
+                tree.parallel_for_each([](int &value) { scramble(value); }, PARALLEL_GRAIN, pool);
+                std::printf(" %10.1f", elapsed_ns(start) / 1e6);
+            }
+            std::printf("\n");
+        }
+    }
+
+    // for_each_bfs vs parallel_bfs on a complete 32-ary tree, same per-node work as above
+    void bench_parallel_bfs(size_t maxNodes)
+    {
+        const size_t threadCounts[] = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+        std::printf("parallel_bfs: ms per pass of scramble() over a complete Tree<int, 32>, %u hardware threads\n",
+                    std::thread::hardware_concurrency());
+        std::printf("%12s %10s %10s %10s %10s %10s\n", "nodes", "serial", "1 thread", "2", "4", "all");
+        for (size_t n = 100000; n <= maxNodes; n *= 10)
+        {
+            Tree<int, 32> tree;
+            std::vector<Node<int> *> nodes{tree.emplace_root(0)};
+            nodes.reserve(n);
+            for (size_t i = 1; i < n; ++i)
+                nodes.push_back(tree.emplace_child(nodes[(i - 1) / 32], static_cast<int>(i)));
+
+            size_t levels = 0;
+            auto onLevel = [&levels](size_t, std::span<Node<int> *const>) { ++levels; };
+            auto start = Clock::now();
+            tree.for_each_bfs([](int &value) { scramble(value); });
+            std::printf("%12zu %10.1f", n, elapsed_ns(start) / 1e6);
+            for (size_t threads : threadCounts)
+            {
+                ThreadPool pool(threads);
+                start = Clock::now();
+                tree.parallel_bfs([](int &value) { scramble(value); }, onLevel, PARALLEL_GRAIN, pool);
+                std::printf(" %10.1f", elapsed_ns(start) / 1e6);
+            }
+            std::printf("\n");
+        }
+    }
+
+    // One row of bench_reduce: the map-based post-order, then reduce() on pools of
+    // 1, 2, 4 and all hardware threads
+    void reduce_row(Tree<int, 3> &tree, size_t n)
+    {
+        const size_t threadCounts[] = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+
+        // Post-order over the nodes, parents reading their children's sums from the map
+        auto start = Clock::now();
+        std::unordered_map<Node<int> *, long> sums;
+        std::vector<std::pair<Node<int> *, bool>> stk{{tree.get_root(), false}};
+        while (!stk.empty())
+        {
+            auto [node, expanded] = stk.back();
+            stk.pop_back();
+            if (!expanded)
+            {
+                stk.emplace_back(node, true);
+                for (Node<int> *child : node->children)
+                    stk.emplace_back(child, false);
+                continue;
+            }
+            long sum = node->value;
+            for (Node<int> *child : node->children)
+                sum += sums[child];
+            sums[node] = sum;
+        }
+        sink = static_cast<double>(sums[tree.get_root()]);
+        std::printf("%12zu %10.1f", n, elapsed_ns(start) / 1e6);
+
+        for (size_t threads : threadCounts)
+        {
+            ThreadPool pool(threads);
+            std::vector<long> perNode;
+            start = Clock::now();
+            long total = tree.reduce(0L, [](int value) { return static_cast<long>(value); },
+                                     [](long x, long y) { return x + y; }, &perNode, PARALLEL_GRAIN, pool);
+            std::printf(" %10.1f", elapsed_ns(start) / 1e6);
+            sink = static_cast<double>(total);
+        }
+        std::printf("\n");
+    }
+
+    // All subtree sums through reduce() vs a serial post-order with a side map, on
+    // random 3-ary trees (wide levels) and on chains (every level one node wide)
+    void bench_reduce(size_t maxNodes)
+    {
+        std::printf("reduce: ms to compute all subtree sums of a random Tree<int, 3>, %u hardware threads\n",
+                    std::thread::hardware_concurrency());
+        std::printf("%12s %10s %10s %10s %10s %10s\n", "nodes", "map", "1 thread", "2", "4", "all");
+        for (size_t n = 100000; n <= maxNodes; n *= 10)
+        {
+            Tree<int, 3> tree;
+            build_random_ternary(tree, n);
+            reduce_row(tree, n);
+        }
+
+        std::printf("reduce: same on a chain (each node has one child)\n");
+        std::printf("%12s %10s %10s %10s %10s %10s\n", "nodes", "map", "1 thread", "2", "4", "all");
+        for (size_t n = 10000; n <= std::min<size_t>(maxNodes, 1000000); n *= 10)
+        {
+            Tree<int, 3> tree;
+            Node<int> *node = tree.emplace_root(0);
+            for (size_t i = 1; i < n; ++i)
+                node = tree.emplace_child(node, static_cast<int>(i));
+            reduce_row(tree, n);
+        }
+    }
+
+    // myHeap on a complete binary tree with random values: the sequential heapify
+    // (one thread, no chunking) vs the parallel heapify on pools of 1 to 64 threads
+    void bench_heap(size_t maxNodes)
+    {
+        const size_t threadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+        std::printf("heap: ms per myHeap() on a complete Tree<int> with random values, %u hardware threads\n",
+                    std::thread::hardware_concurrency());
+        std::printf("%12s %10s", "nodes", "seq");
+        for (size_t threads : threadCounts)
+            std::printf(" %8zu", threads);
+        std::printf("\n");
+        for (size_t n = 100000; n <= maxNodes; n *= 10)
+        {
+            Tree<int> tree;
+            std::vector<Node<int> *> nodes{tree.emplace_root(0)};
+            nodes.reserve(n);
+            for (size_t i = 1; i < n; ++i)
+                nodes.push_back(tree.emplace_child(nodes[(i - 1) / 2], 0));
+
+            auto timed = [&](ThreadPool &pool, size_t grain)
+            {
+                std::mt19937 rng(17);
+                for (Node<int> *node : nodes)
+                    node->value = static_cast<int>(rng());
+                auto start = Clock::now();
+                tree.myHeap(grain, &pool);
+                return elapsed_ns(start) / 1e6;
+            };
+
+            // The first call grows the tree's heap buffers; keep it out of the timings
+            ThreadPool single(1);
+            timed(single, static_cast<size_t>(-1));
+            std::printf("%12zu %10.1f", n, timed(single, static_cast<size_t>(-1)));
+            for (size_t threads : threadCounts)
+            {
+                ThreadPool pool(threads);
+                std::printf(" %8.1f", timed(pool, PARALLEL_GRAIN));
+            }
+            std::printf("\n");
+        }
+    }
+
+    // Cost of the concurrent mode for a single thread: building a random 3-ary tree
+    // (each add copies the child block) and scanning it, Tree vs ConcurrentTree
+    template <typename TreeT>
+    void concurrent_row(size_t n, double &build, double &bfs, double &pre)
+    {
+        typedef std::remove_pointer_t<decltype(std::declval<TreeT &>().get_root())> NodeT;
+        TreeT tree;
+        std::mt19937_64 rng(5);
+        auto start = Clock::now();
+        std::vector<NodeT *> open{tree.emplace_root(0)};
+        for (size_t i = 1; i < n; ++i)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(0, open.size() - 1)(rng);
+            NodeT *parent = open[pick];
+            open.push_back(tree.emplace_child(parent, static_cast<int>(i)));
+            if (parent->children.size() == 3)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+        build = elapsed_ns(start) / n;
+        EpochGuard guard;
+        bfs = walk_ns(tree.begin_bfs_scan(), tree.end_bfs_scan(), n);
+        pre = walk_ns(tree.begin_pre_order(), tree.end_pre_order(), n);
+    }
+
+    void bench_concurrent(size_t maxNodes)
+    {
+        std::printf("concurrent: ns per node, random 3-ary tree, Tree / ConcurrentTree (one thread)\n");
+        std::printf("%12s %16s %16s %16s\n", "nodes", "build", "bfs", "pre-order");
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            double build[2], bfs[2], pre[2];
+            concurrent_row<Tree<int, 3>>(n, build[0], bfs[0], pre[0]);
+            concurrent_row<ConcurrentTree<int, 3>>(n, build[1], bfs[1], pre[1]);
+            EpochDomain::shared().reclaim();
+            std::printf("%12zu   %6.1f / %5.1f   %6.1f / %5.1f   %6.1f / %5.1f\n", n, build[0], build[1], bfs[0], bfs[1], pre[0], pre[1]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string which = argc > 1 ? argv[1] : "all";
+    size_t maxNodes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+
+    if (which == "all" || which == "veb")
+        bench_veb(maxNodes);
+    if (which == "all" || which == "layout")
+        bench_layout(maxNodes);
+    if (which == "all" || which == "shortscan")
+        bench_short_scans(maxNodes);
+    if (which == "all" || which == "traversal")
+        bench_traversal(maxNodes);
+    if (which == "all" || which == "tail")
+        bench_tail(maxNodes);
+    if (which == "all" || which == "visitor")
+        bench_visitor(maxNodes);
+    if (which == "all" || which == "batch")
+        bench_batch(maxNodes);
+    if (which == "all" || which == "prefetch")
+        bench_prefetch(maxNodes);
+    if (which == "all" || which == "generator")
+        bench_generator(maxNodes);
+    if (which == "all" || which == "parallel")
+        bench_parallel(maxNodes);
+    if (which == "all" || which == "parallelbfs")
+        bench_parallel_bfs(maxNodes);
+    if (which == "all" || which == "reduce")
+        bench_reduce(maxNodes);
+    if (which == "all" || which == "heap")
+        bench_heap(maxNodes);
+    if (which == "all" || which == "concurrent")
+        bench_concurrent(maxNodes);
+
+    return 0;
+}
@@ -0,0 +1,629 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef COMPACT_TREE_HPP
+#define COMPACT_TREE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Tree.hpp"
+
+namespace ariel
+{
+    ///// Storage layouts for CompactTree ///////
+
+    // Layout tags: pick how CompactTree lays out values and topology in memory
+    struct ArrayOfStructs {};  // One array of {value, child indices, count} records
+    struct StructOfArrays {};  // Values in one dense array, topology in separate arrays
+    struct HotColdSplit {};    // Cache-line-aligned topology records, values in a separate cold array
+
+    static const size_t CACHE_LINE = 64;
+
+    // Allocator for arrays that must start on a cache line boundary
+    template <typename U>
+    struct CacheAlignedAllocator
+    {
+        typedef U value_type;
+
+        CacheAlignedAllocator() = default;
+        template <typename V>
+        CacheAlignedAllocator(const CacheAlignedAllocator<V> &) {}
+
+        U *allocate(size_t n)
+        {
+            return static_cast<U *>(::operator new(n * sizeof(U), std::align_val_t(CACHE_LINE)));
+        }
+
+        void deallocate(U *p, size_t)
+        {
+            ::operator delete(p, std::align_val_t(CACHE_LINE));
+        }
+
+        template <typename V>
+        bool operator==(const CacheAlignedAllocator<V> &) const { return true; }
+        template <typename V>
+        bool operator!=(const CacheAlignedAllocator<V> &) const { return false; }
+    };
+
+    template <typename T, size_t K, typename Layout>
+    class CompactStorage;
+
+    template <typename T, size_t K>
+    class CompactStorage<T, K, ArrayOfStructs>
+    {
+    private:
+        struct Slot
+        {
+            T value;              // The value stored in the node
+            uint32_t children[K]; // Indices of the child nodes, only the first `count` are valid
+            uint32_t count;       // Number of child slots in use
+        };
+
+        std::vector<Slot> nodes; // All nodes, in insertion order
+
+    public:
+        size_t size() const { return nodes.size(); }
+        void reserve(size_t n) { nodes.reserve(n); }
+
+        void append(const T &val)
+        {
+            nodes.push_back(Slot{val, {}, 0});
+        }
+
+        void link(uint32_t parent, uint32_t child)
+        {
+            Slot &slot = nodes[parent];
+            slot.children[slot.count++] = child;
+        }
+
+        T &value(uint32_t node) { return nodes[node].value; }
+        const T &value(uint32_t node) const { return nodes[node].value; }
+        uint32_t child_count(uint32_t node) const { return nodes[node].count; }
+        uint32_t child(uint32_t node, size_t i) const { return nodes[node].children[i]; }
+    };
+
+    template <typename T, size_t K>
+    class CompactStorage<T, K, StructOfArrays>
+    {
+    private:
+        typedef typename std::conditional<(K < 256), uint8_t, uint32_t>::type count_type;
+
+        std::vector<T> vals;            // values[i] is the value of node i
+        std::vector<uint32_t> links;    // links[i * K + c] is the c'th child of node i
+        std::vector<count_type> counts; // counts[i] is the number of child slots node i uses
+
+    public:
+        size_t size() const { return vals.size(); }
+
+        void reserve(size_t n)
+        {
+            vals.reserve(n);
+            links.reserve(n * K);
+            counts.reserve(n);
+        }
+
+        void append(const T &val)
+        {
+            vals.push_back(val);
+            links.resize(links.size() + K);
+            counts.push_back(0);
+        }
+
+        void link(uint32_t parent, uint32_t child)
+        {
+            links[size_t(parent) * K + counts[parent]++] = child;
+        }
+
+        T &value(uint32_t node) { return vals[node]; }
+        const T &value(uint32_t node) const { return vals[node]; }
+        uint32_t child_count(uint32_t node) const { return counts[node]; }
+        uint32_t child(uint32_t node, size_t i) const { return links[size_t(node) * K + i]; }
+
+        std::span<T> values() { return std::span<T>(vals); }
+        std::span<const T> values() const { return std::span<const T>(vals); }
+    };
+
+    template <typename T, size_t K>
+    class CompactStorage<T, K, HotColdSplit>
+    {
+    private:
+        // Smallest power of two that holds n bytes, capped at one cache line
+        static constexpr size_t record_alignment(size_t n)
+        {
+            size_t a = 1;
+            while (a < n && a < CACHE_LINE)
+                a *= 2;
+            return a;
+        }
+
+        // Everything a traversal touches for one node. Records are padded to a power of
+        // two, so a record never straddles two cache lines (4 records per line for K = 2).
+        struct alignas(record_alignment(sizeof(uint32_t) * (K + 1))) HotRecord
+        {
+            uint32_t children[K]; // Indices of the child nodes, only the first `count` are valid
+            uint32_t count;       // Number of child slots in use
+        };
+
+        std::vector<HotRecord, CacheAlignedAllocator<HotRecord>> hot; // Topology, one record per node
+        std::vector<T> cold;                                          // cold[i] is the value of node i
+
+    public:
+        size_t size() const { return hot.size(); }
+
+        void reserve(size_t n)
+        {
+            hot.reserve(n);
+            cold.reserve(n);
+        }
+
+        void append(const T &val)
+        {
+            hot.push_back(HotRecord{{}, 0});
+            cold.push_back(val);
+        }
+
+        void link(uint32_t parent, uint32_t child)
+        {
+            HotRecord &record = hot[parent];
+            record.children[record.count++] = child;
+        }
+
+        T &value(uint32_t node) { return cold[node]; }
+        const T &value(uint32_t node) const { return cold[node]; }
+        uint32_t child_count(uint32_t node) const { return hot[node].count; }
+        uint32_t child(uint32_t node, size_t i) const { return hot[node].children[i]; }
+
+        std::span<T> values() { return std::span<T>(cold); }
+        std::span<const T> values() const { return std::span<const T>(cold); }
+    };
+
+    // K-ary tree stored in contiguous arrays, with children linked by 32-bit indices
+    // instead of Node pointers. Node indices are stable: they never change once assigned.
+    // A child slot holds npos where the source tree had a missing child before a real
+    // one (e.g. a binary node with only a right child), so slot positions are kept.
+    template <typename T, size_t K = 2, typename Layout = ArrayOfStructs>
+    class CompactTree
+    {
+    public:
+        static const uint32_t npos = 0xFFFFFFFFu; // "No node" index (end iterators, missing root or child)
+
+    private:
+        CompactStorage<T, K, Layout> nodes; // All nodes, in insertion order
+        uint32_t root;                      // Index of the root node
+
+        uint32_t append(const T &val)
+        {
+            if (nodes.size() >= npos)
+                throw std::overflow_error("CompactTree is full.");
+            nodes.append(val);
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        void heapify(uint32_t node)
+        {
+            // Sift the value down until both children are larger (min-heap)
+            while (true)
+            {
+                uint32_t smallest = node;
+                uint32_t count = nodes.child_count(node);
+                for (uint32_t c = 0; c < count && c < 2; ++c)
+                {
+                    uint32_t child = nodes.child(node, c);
+                    if (child != npos && nodes.value(child) < nodes.value(smallest))
+                    {
+                        smallest = child;
+                    }
+                }
+                if (smallest == node)
+                {
+                    return;
+                }
+                std::swap(nodes.value(node), nodes.value(smallest));
+                node = smallest;
+            }
+        }
+
+    public:
+        ///// Iterators: same visit orders as the iterators in TreeIterators.hpp ///////
+
+        // Shared part of all iterators: current node index and access to its value
+        template <typename Derived>
+        class IteratorBase
+        {
+        protected:
+            CompactTree *tree;
+            uint32_t current;
+
+            IteratorBase(CompactTree *t) : tree(t), current(npos) {}
+
+        public:
+            T &operator*() const
+            {
+                return tree->value(current);
+            }
+
+            T *operator->() const
+            {
+                return &tree->value(current);
+            }
+
+            // Index of the current node (npos at the end)
+            uint32_t index() const
+            {
+                return current;
+            }
+
+            Derived operator++(int)
+            {
+                Derived temp = static_cast<Derived &>(*this);
+                ++static_cast<Derived &>(*this);
+                return temp;
+            }
+
+            bool operator==(const Derived &other) const
+            {
+                return current == other.current;
+            }
+
+            bool operator!=(const Derived &other) const
+            {
+                return current != other.current;
+            }
+        };
+
+        // Pre-order (current, children left to right); also used for DFS
+        class PreOrderIterator : public IteratorBase<PreOrderIterator>
+        {
+        private:
+            std::vector<uint32_t> stk; // Nodes still to visit, next one on top
+
+        public:
+            using IteratorBase<PreOrderIterator>::operator++;
+
+            PreOrderIterator(CompactTree *t = nullptr, uint32_t start = npos) : IteratorBase<PreOrderIterator>(t)
+            {
+                if (start != npos)
+                {
+                    stk.push_back(start);
+                    ++(*this);
+                }
+            }
+
+            PreOrderIterator &operator++()
+            {
+                if (stk.empty())
+                {
+                    this->current = npos;
+                    return *this;
+                }
+                this->current = stk.back();
+                stk.pop_back();
+                const CompactTree *t = this->tree;
+                for (uint32_t c = t->child_count(this->current); c > 0; --c)
+                {
+                    uint32_t child = t->child(this->current, c - 1);
+                    if (child != npos)
+                        stk.push_back(child);
+                }
+                return *this;
+            }
+        };
+
+        // Post-order (children left to right, then current)
+        class PostOrderIterator : public IteratorBase<PostOrderIterator>
+        {
+        private:
+            struct Frame
+            {
+                uint32_t node; // Node whose children are being visited
+                uint32_t next; // Next child of `node` to descend into
+            };
+            std::vector<Frame> stk;
+
+        public:
+            using IteratorBase<PostOrderIterator>::operator++;
+
+            PostOrderIterator(CompactTree *t = nullptr, uint32_t start = npos) : IteratorBase<PostOrderIterator>(t)
+            {
+                if (start != npos)
+                {
+                    stk.push_back(Frame{start, 0});
+                    ++(*this);
+                }
+            }
+
+            PostOrderIterator &operator++()
+            {
+                while (!stk.empty())
+                {
+                    Frame &top = stk.back();
+                    if (top.next < this->tree->child_count(top.node))
+                    {
+                        uint32_t child = this->tree->child(top.node, top.next++);
+                        if (child != npos)
+                            stk.push_back(Frame{child, 0});
+                    }
+                    else
+                    {
+                        this->current = top.node;
+                        stk.pop_back();
+                        return *this;
+                    }
+                }
+                this->current = npos;
+                return *this;
+            }
+        };
+
+        // In-order for binary trees (left, current, right); pre-order for general trees
+        class InOrderIterator : public IteratorBase<InOrderIterator>
+        {
+        private:
+            std::vector<uint32_t> stk;
+
+            void push_left(uint32_t node)
+            {
+                while (node != npos)
+                {
+                    stk.push_back(node);
+                    node = this->tree->child_count(node) > 0 ? this->tree->child(node, 0) : npos;
+                }
+            }
+
+        public:
+            using IteratorBase<InOrderIterator>::operator++;
+
+            InOrderIterator(CompactTree *t = nullptr, uint32_t start = npos) : IteratorBase<InOrderIterator>(t)
+            {
+                if (start != npos)
+                {
+                    if (K == 2)
+                        push_left(start);
+                    else
+                        stk.push_back(start);
+                    ++(*this);
+                }
+            }
+
+            InOrderIterator &operator++()
+            {
+                if (stk.empty())
+                {
+                    this->current = npos;
+                    return *this;
+                }
+                this->current = stk.back();
+                stk.pop_back();
+                const CompactTree *t = this->tree;
+                if (K == 2)
+                {
+                    if (t->child_count(this->current) > 1)
+                        push_left(t->child(this->current, 1));
+                }
+                else
+                {
+                    for (uint32_t c = t->child_count(this->current); c > 0; --c)
+                    {
+                        uint32_t child = t->child(this->current, c - 1);
+                        if (child != npos)
+                            stk.push_back(child);
+                    }
+                }
+                return *this;
+            }
+        };
+
+        // Level order; also used to walk the heap produced by myHeap
+        class BFSIterator : public IteratorBase<BFSIterator>
+        {
+        private:
+            std::deque<uint32_t> q;
+
+        public:
+            using IteratorBase<BFSIterator>::operator++;
+
+            BFSIterator(CompactTree *t = nullptr, uint32_t start = npos) : IteratorBase<BFSIterator>(t)
+            {
+                if (start != npos)
+                {
+                    q.push_back(start);
+                    ++(*this);
+                }
+            }
+
+            BFSIterator &operator++()
+            {
+                if (q.empty())
+                {
+                    this->current = npos;
+                    return *this;
+                }
+                this->current = q.front();
+                q.pop_front();
+                const CompactTree *t = this->tree;
+                uint32_t count = t->child_count(this->current);
+                for (uint32_t c = 0; c < count; ++c)
+                {
+                    uint32_t child = t->child(this->current, c);
+                    if (child != npos)
+                        q.push_back(child);
+                }
+                return *this;
+            }
+        };
+
+        typedef PreOrderIterator DFSIterator;
+        typedef BFSIterator HeapIterator;
+
+        CompactTree() : root(npos) {}
+
+        // Copy a pointer-based tree, laying the nodes out in BFS order. A missing child
+        // followed by a real one keeps its slot (as npos); trailing missing children are dropped.
+        template <typename NodeT>
+        explicit CompactTree(const Tree<T, K, NodeT> &tree) : root(npos)
+        {
+            NodeT *src = tree.get_root();
+            if (!src)
+                return;
+
+            std::vector<NodeT *> order; // Source nodes in BFS order; order[i] becomes index i
+            order.push_back(src);
+            root = append(src->value);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                uint32_t missing = 0; // Empty slots seen since the last real child
+                for (auto child : order[i]->children)
+                {
+                    if (!child)
+                    {
+                        ++missing;
+                        continue;
+                    }
+                    for (; missing > 0; --missing)
+                    {
+                        nodes.link(static_cast<uint32_t>(i), npos);
+                    }
+                    order.push_back(child);
+                    add_sub_node(static_cast<uint32_t>(i), child->value);
+                }
+            }
+        }
+
+        bool is_binary() const
+        {
+            return K == 2;
+        }
+
+        // Reserve room for n nodes so building the tree does not reallocate
+        void reserve(size_t n)
+        {
+            nodes.reserve(n);
+        }
+
+        // Add a new root node and return its index
+        uint32_t add_root(const T &val)
+        {
+            root = append(val);
+            return root;
+        }
+
+        // Add a child of the node at index `parent` and return the child's index
+        uint32_t add_sub_node(uint32_t parent, const T &val)
+        {
+            if (parent >= nodes.size())
+                throw std::invalid_argument("Parent node does not exist.");
+            if (nodes.child_count(parent) >= K)
+                throw std::overflow_error("Maximum number of children reached.");
+            uint32_t child = append(val);
+            nodes.link(parent, child);
+            return child;
+        }
+
+        uint32_t get_root() const
+        {
+            return root;
+        }
+
+        size_t size() const
+        {
+            return nodes.size();
+        }
+
+        T &value(uint32_t node)
+        {
+            return nodes.value(node);
+        }
+
+        const T &value(uint32_t node) const
+        {
+            return nodes.value(node);
+        }
+
+        // Number of child slots in use, including npos slots of missing children
+        uint32_t child_count(uint32_t node) const
+        {
+            return nodes.child_count(node);
+        }
+
+        // Index of the i'th child, npos if that child is missing
+        uint32_t child(uint32_t node, size_t i) const
+        {
+            return nodes.child(node, i);
+        }
+
+        // All node values as one dense array (node i's value is values()[i]).
+        // Only available with the StructOfArrays and HotColdSplit layouts.
+        std::span<T> values()
+        {
+            static_assert(!std::is_same<Layout, ArrayOfStructs>::value, "values() needs a layout with a separate value array.");
+            return nodes.values();
+        }
+
+        std::span<const T> values() const
+        {
+            static_assert(!std::is_same<Layout, ArrayOfStructs>::value, "values() needs a layout with a separate value array.");
+            return nodes.values();
+        }
+
+        PreOrderIterator begin_pre_order() { return PreOrderIterator(this, root); }
+        PreOrderIterator end_pre_order() { return PreOrderIterator(this); }
+
+        PostOrderIterator begin_post_order() { return PostOrderIterator(this, root); }
+        PostOrderIterator end_post_order() { return PostOrderIterator(this); }
+
+        InOrderIterator begin_in_order() { return InOrderIterator(this, root); }
+        InOrderIterator end_in_order() { return InOrderIterator(this); }
+
+        BFSIterator begin_bfs_scan() { return BFSIterator(this, root); }
+        BFSIterator end_bfs_scan() { return BFSIterator(this); }
+
+        DFSIterator begin_dfs_scan() { return DFSIterator(this, root); }
+        DFSIterator end_dfs_scan() { return DFSIterator(this); }
+
+        // Convert the binary tree into a min-heap and return a level-order iterator over it
+        HeapIterator myHeap()
+        {
+            if (!is_binary())
+            {
+                throw std::logic_error("The tree is not binary.");
+            }
+            if (root == npos)
+                return HeapIterator(this);
+
+            // Collect the nodes in level order, then heapify them in reverse level order
+            std::vector<uint32_t> order;
+            order.reserve(nodes.size());
+            order.push_back(root);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                uint32_t count = nodes.child_count(order[i]);
+                for (uint32_t c = 0; c < count; ++c)
+                {
+                    uint32_t child = nodes.child(order[i], c);
+                    if (child != npos)
+                        order.push_back(child);
+                }
+            }
+            for (size_t i = order.size(); i > 0; --i)
+            {
+                heapify(order[i - 1]);
+            }
+
+            return HeapIterator(this, root);
+        }
+    };
+
+    template <typename T, size_t K, typename Layout>
+    const uint32_t CompactTree<T, K, Layout>::npos;
+}
+
+#endif
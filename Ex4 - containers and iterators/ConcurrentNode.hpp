@@ -0,0 +1,218 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef CONCURRENT_NODE_HPP
+#define CONCURRENT_NODE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include "Epoch.hpp"
+
+namespace ariel
+{
+    // Child list that one writer can append to while any number of readers iterate
+    // over it. The children live in an immutable block; push_back() builds a copy
+    // with the new child, publishes it with one atomic store and retires the old
+    // block through EpochDomain::shared(), which frees it once no reader holding an
+    // EpochGuard can still see it. A reader therefore sees either the old or the new
+    // list, never a half-written one. Every call loads the current block, so
+    // iterators keep the block they started on, and end()/rend() are sentinels that
+    // match any iterator which ran off its own block. Indices stay valid across
+    // appends: an index below an earlier size() is valid in every later block.
+    // Offers the read-only subset of the std::vector interface that the tree and its
+    // iterators use, plus push_back() for the writer.
+    template <typename Ptr>
+    class AtomicChildList
+    {
+        static_assert(std::is_trivially_copyable<Ptr>::value, "AtomicChildList holds plain values such as node pointers");
+
+    private:
+        // Header of a block; the `count` children follow it in the same allocation
+        struct Block
+        {
+            size_t count;
+
+            Ptr *items() { return reinterpret_cast<Ptr *>(this + 1); }
+            const Ptr *items() const { return reinterpret_cast<const Ptr *>(this + 1); }
+        };
+
+        static_assert(alignof(Ptr) <= alignof(Block), "Children must fit right after the block header");
+
+        std::pmr::memory_resource *resource; // Where the blocks are allocated
+        std::atomic<Block *> block;          // Current children, nullptr while there are none
+
+        static size_t block_bytes(size_t count)
+        {
+            return sizeof(Block) + count * sizeof(Ptr);
+        }
+
+        Block *current() const
+        {
+            return block.load(std::memory_order_acquire);
+        }
+
+        template <bool Reverse>
+        class basic_iterator
+        {
+        private:
+            const Block *snapshot; // nullptr for the end sentinel
+            size_t index;          // Next item; for reverse iterators, one past it
+
+            bool at_end() const
+            {
+                return !snapshot || (Reverse ? index == 0 : index == snapshot->count);
+            }
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef Ptr value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const Ptr *pointer;
+            typedef const Ptr &reference;
+
+            basic_iterator() : snapshot(nullptr), index(0) {}
+            basic_iterator(const Block *snapshot, size_t index) : snapshot(snapshot), index(index) {}
+
+            const Ptr &operator*() const
+            {
+                return Reverse ? snapshot->items()[index - 1] : snapshot->items()[index];
+            }
+
+            basic_iterator &operator++()
+            {
+                Reverse ? --index : ++index;
+                return *this;
+            }
+
+            basic_iterator operator++(int)
+            {
+                basic_iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const basic_iterator &other) const
+            {
+                if (at_end() || other.at_end())
+                    return at_end() && other.at_end();
+                return snapshot == other.snapshot && index == other.index;
+            }
+        };
+
+    public:
+        typedef Ptr value_type;
+        typedef basic_iterator<false> iterator;
+        typedef basic_iterator<false> const_iterator;
+        typedef basic_iterator<true> reverse_iterator;
+        typedef basic_iterator<true> const_reverse_iterator;
+
+        explicit AtomicChildList(std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), block(nullptr)
+        {
+        }
+
+        AtomicChildList(const AtomicChildList &) = delete;
+        AtomicChildList &operator=(const AtomicChildList &) = delete;
+
+        // Only for nodes nobody else can see yet (e.g. while a node block is built)
+        AtomicChildList(AtomicChildList &&other) noexcept
+            : resource(other.resource), block(other.block.exchange(nullptr))
+        {
+        }
+
+        // Readers must be gone: the current block is freed right away
+        ~AtomicChildList()
+        {
+            Block *last = block.load();
+            if (last)
+                resource->deallocate(last, block_bytes(last->count), alignof(Block));
+        }
+
+        size_t size() const
+        {
+            Block *children = current();
+            return children ? children->count : 0;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        const Ptr &operator[](size_t i) const
+        {
+            return current()->items()[i];
+        }
+
+        const_iterator begin() const { return const_iterator(current(), 0); }
+        const_iterator end() const { return const_iterator(); }
+
+        const_reverse_iterator rbegin() const
+        {
+            Block *children = current();
+            return const_reverse_iterator(children, children ? children->count : 0);
+        }
+
+        const_reverse_iterator rend() const { return const_reverse_iterator(); }
+
+        // Writer only (one at a time): publish a copy of the list with `child` appended
+        void push_back(const Ptr &child)
+        {
+            Block *old = block.load(std::memory_order_relaxed);
+            size_t count = old ? old->count : 0;
+            Block *grown = static_cast<Block *>(resource->allocate(block_bytes(count + 1), alignof(Block)));
+            grown->count = count + 1;
+            if (old)
+                std::copy(old->items(), old->items() + count, grown->items());
+            grown->items()[count] = child;
+            block.store(grown, std::memory_order_seq_cst);
+            if (old)
+                EpochDomain::shared().retire(old, block_bytes(count), alignof(Block), resource);
+        }
+    };
+
+    // Node of a tree that readers scan while one writer adds nodes (ConcurrentTree).
+    // The children are an AtomicChildList; everything else is set before the node is
+    // published by add_child(), so a reader that reaches the node sees its value.
+    template <typename T>
+    class ConcurrentNode
+    {
+    public:
+        typedef AtomicChildList<ConcurrentNode *> ChildList;
+
+        T value;            // The value stored in the node
+        ChildList children; // Pointers to child nodes
+
+        ConcurrentNode(const T &val) : value(val) {}
+
+        // The child blocks are allocated from the given memory resource
+        ConcurrentNode(const T &val, std::pmr::memory_resource *resource) : value(val), children(resource) {}
+
+        ConcurrentNode(ConcurrentNode &&other) noexcept : value(std::move(other.value)), children(std::move(other.children)) {}
+
+        void add_child(ConcurrentNode *child)
+        {
+            children.push_back(child);
+        }
+
+        T &get_value()
+        {
+            return value;
+        }
+
+        const T &get_value() const
+        {
+            return value;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef EPOCH_HPP
+#define EPOCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ariel
+{
+    // Epoch-based reclamation. Readers announce the global epoch they entered in
+    // (EpochGuard) and never wait for anything. A writer that replaces a block that
+    // readers may still be reading hands the old block to retire(), which tags it
+    // with the current epoch and moves the global epoch forward; the block is freed
+    // once every reader that was active in that epoch or before has left. Readers
+    // that enter later can only see the replacement.
+    class EpochDomain
+    {
+    private:
+        static constexpr size_t SLOTS = 256;        // Readers that can be inside at the same time
+        static constexpr size_t RECLAIM_BATCH = 64; // Retired blocks that trigger a reclaim()
+
+        // One reader's announced epoch (0: free slot), on its own cache line
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> epoch{0};
+        };
+
+        struct Retired
+        {
+            void *block;
+            size_t bytes;
+            size_t alignment;
+            std::pmr::memory_resource *resource;
+            uint64_t epoch; // Global epoch when the block was unlinked
+        };
+
+        std::atomic<uint64_t> globalEpoch;
+        Slot slots[SLOTS];
+        std::mutex retiredLock; // Writers only; readers never take it
+        std::vector<Retired> retired;
+
+        // Smallest epoch a reader is inside, UINT64_MAX if there is none
+        uint64_t oldest_reader() const
+        {
+            uint64_t oldest = UINT64_MAX;
+            for (const Slot &slot : slots)
+            {
+                uint64_t epoch = slot.epoch.load();
+                if (epoch != 0 && epoch < oldest)
+                    oldest = epoch;
+            }
+            return oldest;
+        }
+
+        size_t reclaim_locked()
+        {
+            uint64_t oldest = oldest_reader();
+            size_t kept = 0;
+            size_t freed = 0;
+            for (Retired &block : retired)
+            {
+                if (block.epoch < oldest)
+                {
+                    block.resource->deallocate(block.block, block.bytes, block.alignment);
+                    ++freed;
+                }
+                else
+                {
+                    retired[kept++] = block;
+                }
+            }
+            retired.resize(kept);
+            return freed;
+        }
+
+    public:
+        EpochDomain() : globalEpoch(1) {}
+        EpochDomain(const EpochDomain &) = delete;
+        EpochDomain &operator=(const EpochDomain &) = delete;
+
+        // Nobody may be reading when the domain goes away
+        ~EpochDomain()
+        {
+            for (Retired &block : retired)
+                block.resource->deallocate(block.block, block.bytes, block.alignment);
+        }
+
+        // Domain used by AtomicChildList (and so by every ConcurrentNode)
+        static EpochDomain &shared()
+        {
+            static EpochDomain domain;
+            return domain;
+        }
+
+        // Announce a reader; returns its slot for leave()
+        size_t enter()
+        {
+            thread_local size_t hint = 0; // Slot this thread used last time
+            for (size_t tries = 0; tries < SLOTS; ++tries)
+            {
+                size_t i = (hint + tries) % SLOTS;
+                uint64_t expected = 0;
+                uint64_t epoch = globalEpoch.load();
+                if (slots[i].epoch.compare_exchange_strong(expected, epoch))
+                {
+                    // A writer may have moved the epoch on before seeing the announcement:
+                    // announce the new one until it is current
+                    uint64_t now;
+                    while ((now = globalEpoch.load()) != epoch)
+                    {
+                        slots[i].epoch.store(now);
+                        epoch = now;
+                    }
+                    hint = i;
+                    return i;
+                }
+            }
+            throw std::overflow_error("Too many concurrent readers.");
+        }
+
+        void leave(size_t slot)
+        {
+            slots[slot].epoch.store(0);
+        }
+
+        // Free `block` once no reader can still reach it. Call after the block was
+        // unlinked (replaced by a new one that readers load from now on).
+        void retire(void *block, size_t bytes, size_t alignment, std::pmr::memory_resource *resource)
+        {
+            uint64_t epoch = globalEpoch.fetch_add(1);
+            std::lock_guard<std::mutex> guard(retiredLock);
+            retired.push_back(Retired{block, bytes, alignment, resource, epoch});
+            if (retired.size() >= RECLAIM_BATCH)
+                reclaim_locked();
+        }
+
+        // Free every retired block that no reader can reach; returns how many were freed
+        size_t reclaim()
+        {
+            std::lock_guard<std::mutex> guard(retiredLock);
+            return reclaim_locked();
+        }
+
+        // Wait for the readers inside now to leave, then free every retired block. Call it
+        // before destroying a memory resource that retired blocks came from.
+        void drain()
+        {
+            uint64_t epoch = globalEpoch.fetch_add(1);
+            while (oldest_reader() <= epoch)
+                std::this_thread::yield();
+            reclaim();
+        }
+
+        // Retired blocks not freed yet
+        size_t pending()
+        {
+            std::lock_guard<std::mutex> guard(retiredLock);
+            return retired.size();
+        }
+    };
+
+    // Marks the current thread as a reader of the domain's structures for its lifetime.
+    // Hold one around every scan of a ConcurrentTree that may run while a writer adds
+    // nodes; the nodes and child lists it reaches stay valid until it is destroyed.
+    class EpochGuard
+    {
+    private:
+        EpochDomain &domain;
+        size_t slot;
+
+    public:
+        explicit EpochGuard(EpochDomain &domain = EpochDomain::shared())
+            : domain(domain), slot(domain.enter())
+        {
+        }
+
+        EpochGuard(const EpochGuard &) = delete;
+        EpochGuard &operator=(const EpochGuard &) = delete;
+
+        ~EpochGuard()
+        {
+            domain.leave(slot);
+        }
+    };
+}
+
+#endif
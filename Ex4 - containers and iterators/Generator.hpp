@@ -0,0 +1,247 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ariel
+{
+    // Per-thread cache of coroutine frames. A finished generator returns its frame
+    // here instead of freeing it, and the next generator of a similar size takes it
+    // back, so creating a traversal in a loop stops allocating after the first one.
+    // Frames are grouped in 64-byte size classes; frames above 1 KiB, and blocks
+    // beyond the per-class limit, go straight to operator new/delete.
+    class FrameCache
+    {
+    private:
+        static constexpr size_t GRANULE = 64;   // Size class width in bytes
+        static constexpr size_t CLASSES = 16;   // Frames up to CLASSES * GRANULE bytes are cached
+        static constexpr size_t MAX_CACHED = 8; // Blocks kept per size class
+
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        FreeBlock *freeLists[CLASSES]; // Released blocks, per size class
+        size_t cached[CLASSES];        // Length of each free list
+        size_t fresh;                  // Blocks taken from operator new so far
+
+        FrameCache() : freeLists(), cached(), fresh(0) {}
+
+        static size_t size_class(size_t size)
+        {
+            return (size + GRANULE - 1) / GRANULE - 1;
+        }
+
+    public:
+        FrameCache(const FrameCache &) = delete;
+        FrameCache &operator=(const FrameCache &) = delete;
+
+        ~FrameCache()
+        {
+            for (size_t i = 0; i < CLASSES; ++i)
+            {
+                while (freeLists[i])
+                {
+                    FreeBlock *block = freeLists[i];
+                    freeLists[i] = block->next;
+                    ::operator delete(block);
+                }
+            }
+        }
+
+        // The calling thread's cache
+        static FrameCache &local()
+        {
+            thread_local FrameCache cache;
+            return cache;
+        }
+
+        void *allocate(size_t size)
+        {
+            size_t cls = size_class(size);
+            if (cls < CLASSES && freeLists[cls])
+            {
+                FreeBlock *block = freeLists[cls];
+                freeLists[cls] = block->next;
+                --cached[cls];
+                return block;
+            }
+            ++fresh;
+            // Round up so that any frame of the same class can reuse the block
+            return ::operator new(cls < CLASSES ? (cls + 1) * GRANULE : size);
+        }
+
+        void deallocate(void *frame, size_t size)
+        {
+            size_t cls = size_class(size);
+            if (cls < CLASSES && cached[cls] < MAX_CACHED)
+            {
+                freeLists[cls] = ::new (frame) FreeBlock{freeLists[cls]};
+                ++cached[cls];
+                return;
+            }
+            ::operator delete(frame);
+        }
+
+        // Number of frames that had to be allocated (the rest were recycled)
+        size_t fresh_allocations() const
+        {
+            return fresh;
+        }
+    };
+
+    // Lazy sequence produced by a coroutine that does `co_yield value;` for each
+    // element. The generator yields references: `value` must outlive the suspension,
+    // which holds for the tree values yielded by Tree::traverse(). Use it in a
+    // range-for, or keep the iterator and advance it whenever convenient (the
+    // coroutine only runs inside ++ and begin()). Move-only; destroying it ends the
+    // coroutine. An exception thrown by the coroutine is rethrown from begin()/++.
+    template <typename T>
+    class Generator
+    {
+    public:
+        struct promise_type
+        {
+            T *current = nullptr;     // Element of the last co_yield
+            std::exception_ptr error; // Exception that ended the coroutine, if any
+
+            Generator get_return_object()
+            {
+                return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+
+            std::suspend_always yield_value(T &value) noexcept
+            {
+                current = std::addressof(value);
+                return {};
+            }
+
+            void return_void() {}
+
+            void unhandled_exception()
+            {
+                error = std::current_exception();
+            }
+
+            // Frames come from (and go back to) the thread's FrameCache
+            static void *operator new(size_t size)
+            {
+                return FrameCache::local().allocate(size);
+            }
+
+            static void operator delete(void *frame, size_t size)
+            {
+                FrameCache::local().deallocate(frame, size);
+            }
+        };
+
+        typedef std::coroutine_handle<promise_type> handle_type;
+
+        class iterator
+        {
+        private:
+            handle_type coroutine; // nullptr for a default-constructed iterator
+
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef typename std::remove_cv<T>::type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef T *pointer;
+            typedef T &reference;
+
+            iterator() : coroutine(nullptr) {}
+            explicit iterator(handle_type coroutine) : coroutine(coroutine) {}
+
+            T &operator*() const
+            {
+                return *coroutine.promise().current;
+            }
+
+            T *operator->() const
+            {
+                return coroutine.promise().current;
+            }
+
+            // Runs the coroutine up to its next co_yield (or its end)
+            iterator &operator++()
+            {
+                coroutine.resume();
+                if (coroutine.done() && coroutine.promise().error)
+                {
+                    std::rethrow_exception(std::exchange(coroutine.promise().error, nullptr));
+                }
+                return *this;
+            }
+
+            void operator++(int)
+            {
+                ++*this;
+            }
+
+            bool operator==(std::default_sentinel_t) const
+            {
+                return !coroutine || coroutine.done();
+            }
+        };
+
+        Generator() : coroutine(nullptr) {}
+
+        Generator(Generator &&other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+
+        Generator &operator=(Generator &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (coroutine)
+                    coroutine.destroy();
+                coroutine = std::exchange(other.coroutine, nullptr);
+            }
+            return *this;
+        }
+
+        ~Generator()
+        {
+            if (coroutine)
+                coroutine.destroy();
+        }
+
+        // Starts the coroutine; call once
+        iterator begin()
+        {
+            if (!coroutine)
+                return iterator();
+            iterator it(coroutine);
+            ++it;
+            return it;
+        }
+
+        std::default_sentinel_t end() const
+        {
+            return std::default_sentinel;
+        }
+
+    private:
+        handle_type coroutine;
+
+        explicit Generator(handle_type coroutine) : coroutine(coroutine) {}
+    };
+}
+
+#endif
@@ -7,25 +7,134 @@
 #ifndef NODE_HPP
 #define NODE_HPP
 
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace ariel
 {
-    template <typename T>
-    class Node
+    // Fixed-capacity child list stored inside the node itself (no heap allocation).
+    // Offers the subset of the std::vector interface that the tree and its iterators use.
+    template <typename Ptr, size_t N>
+    class InlineChildren
+    {
+    private:
+        typedef typename std::conditional<(N < 256), unsigned char, size_t>::type count_type;
+
+        Ptr items[N];     // Child pointers, only the first `count` are valid
+        count_type count; // Number of children currently stored
+
+    public:
+        typedef Ptr value_type;
+        typedef Ptr *iterator;
+        typedef const Ptr *const_iterator;
+        typedef std::reverse_iterator<iterator> reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        InlineChildren() : count(0) {}
+        explicit InlineChildren(std::pmr::memory_resource *) : count(0) {} // Nothing to allocate
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        static size_t capacity() { return N; }
+
+        Ptr &operator[](size_t i) { return items[i]; }
+        const Ptr &operator[](size_t i) const { return items[i]; }
+
+        Ptr &back() { return items[count - 1]; }
+        const Ptr &back() const { return items[count - 1]; }
+
+        void push_back(const Ptr &child)
+        {
+            if (count == N)
+                throw std::overflow_error("Maximum number of children reached.");
+            items[count++] = child;
+        }
+
+        void pop_back()
+        {
+            --count;
+        }
+
+        iterator begin() { return items; }
+        iterator end() { return items + count; }
+        const_iterator begin() const { return items; }
+        const_iterator end() const { return items + count; }
+
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    };
+
+    // Optional link from a node to its parent. The disabled version is an empty
+    // base class, so nodes without parent links do not grow.
+    template <typename NodePtr, bool Enabled>
+    class ParentLink
+    {
+    public:
+        static constexpr bool HAS_PARENT = false;
+
+    protected:
+        void set_parent(NodePtr) {}
+    };
+
+    template <typename NodePtr>
+    class ParentLink<NodePtr, true>
+    {
+    public:
+        static constexpr bool HAS_PARENT = true;
+
+        NodePtr parent = nullptr; // The node this one was added to, nullptr for a root
+
+        NodePtr get_parent() const
+        {
+            return parent;
+        }
+
+    protected:
+        void set_parent(NodePtr node)
+        {
+            parent = node;
+        }
+    };
+
+    // N == 0: children are kept in a std::pmr::vector (unbounded fan-out).
+    // N > 0:  up to N children are stored inline, e.g. Node<T, 2> for binary trees.
+    // WithParent: every node also points to its parent, set by add_child(); this is
+    //   what the stackless iterators need to walk back up the tree.
+    template <typename T, size_t N = 0, bool WithParent = false>
+    class Node : public ParentLink<Node<T, N, WithParent> *, WithParent>
     {
     public:
-        T value;                         // The value stored in the node
-        std::vector<Node<T> *> children; // Vector of pointers to child nodes
+        typedef typename std::conditional<N == 0, std::pmr::vector<Node *>, InlineChildren<Node *, N>>::type ChildList;
+
+        T value;            // The value stored in the node
+        ChildList children; // Pointers to child nodes
 
         Node(const T &val) : value(val) {}
 
-        void add_child(Node<T> *child)
+        // The child list allocates from the given memory resource
+        Node(const T &val, std::pmr::memory_resource *resource) : value(val), children(resource) {}
+
+        void add_child(Node *child)
         {
             children.push_back(child);
+            if (child)
+            {
+                child->set_parent(this);
+            }
+        }
+
+        T& get_value()
+        {
+            return value;
         }
 
-        T& get_value()  
+        const T &get_value() const
         {
             return value;
         }
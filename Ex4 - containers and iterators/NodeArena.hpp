@@ -0,0 +1,141 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef NODE_ARENA_HPP
+#define NODE_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ariel
+{
+    // Slab allocator for tree nodes: nodes are carved out of large contiguous blocks
+    // and are all released together when the arena is cleared or destroyed.
+    // Slabs are taken from the memory resource given to the constructor.
+    template <typename NodeT>
+    class NodeArena
+    {
+    private:
+        static const size_t FIRST_SLAB = 64;     // Nodes in the first slab
+        static const size_t MAX_SLAB = 1 << 16;  // Slabs stop growing at this many nodes
+
+        struct Slab
+        {
+            NodeT *nodes;    // Raw storage for `capacity` nodes
+            size_t capacity; // Number of node slots in this slab
+        };
+
+        std::pmr::memory_resource *resource; // Where the slabs are allocated
+        std::pmr::vector<Slab> slabs;        // All slabs, the last one is the one being filled
+        size_t used;                         // Number of constructed nodes in the last slab
+        size_t count;                        // Total number of nodes handed out
+
+        void add_slab()
+        {
+            size_t capacity = slabs.empty() ? FIRST_SLAB : slabs.back().capacity * 2;
+            if (capacity > MAX_SLAB)
+            {
+                capacity = MAX_SLAB;
+            }
+            NodeT *nodes = static_cast<NodeT *>(resource->allocate(capacity * sizeof(NodeT), alignof(NodeT)));
+            slabs.push_back(Slab{nodes, capacity});
+            used = 0;
+        }
+
+        // Run the node destructors (skipped entirely for trivially destructible nodes)
+        void destroy_nodes()
+        {
+            if (std::is_trivially_destructible<NodeT>::value)
+            {
+                return;
+            }
+            for (size_t s = 0; s < slabs.size(); ++s)
+            {
+                size_t constructed = (s + 1 == slabs.size()) ? used : slabs[s].capacity;
+                for (size_t i = 0; i < constructed; ++i)
+                {
+                    slabs[s].nodes[i].~NodeT();
+                }
+            }
+        }
+
+    public:
+        explicit NodeArena(std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), slabs(res), used(0), count(0)
+        {
+        }
+
+        NodeArena(const NodeArena &) = delete;
+        NodeArena &operator=(const NodeArena &) = delete;
+
+        NodeArena(NodeArena &&other) noexcept
+            : resource(other.resource), slabs(std::move(other.slabs)), used(other.used), count(other.count)
+        {
+            other.slabs.clear();
+            other.used = 0;
+            other.count = 0;
+        }
+
+        NodeArena &operator=(NodeArena &&other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                resource = other.resource;
+                slabs = std::move(other.slabs);
+                used = other.used;
+                count = other.count;
+                other.slabs.clear();
+                other.used = 0;
+                other.count = 0;
+            }
+            return *this;
+        }
+
+        ~NodeArena()
+        {
+            clear();
+        }
+
+        // Construct a new node in the arena and return a stable pointer to it
+        template <typename... Args>
+        NodeT *create(Args &&...args)
+        {
+            if (slabs.empty() || used == slabs.back().capacity)
+            {
+                add_slab();
+            }
+            NodeT *node = new (slabs.back().nodes + used) NodeT(std::forward<Args>(args)...);
+            ++used;
+            ++count;
+            return node;
+        }
+
+        // Release every node at once; pointers handed out earlier become invalid
+        void clear()
+        {
+            destroy_nodes();
+            for (size_t s = 0; s < slabs.size(); ++s)
+            {
+                resource->deallocate(slabs[s].nodes, slabs[s].capacity * sizeof(NodeT), alignof(NodeT));
+            }
+            slabs.clear();
+            used = 0;
+            count = 0;
+        }
+
+        // Number of nodes allocated from this arena
+        size_t size() const
+        {
+            return count;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef SMALL_STACK_HPP
+#define SMALL_STACK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace ariel
+{
+    // Stack that keeps its first N items inside the object itself and only takes
+    // memory from its resource when it grows past N (e.g. for very deep trees).
+    // Building an empty stack, or copying a stack of at most N items, never allocates.
+    // Offers the subset of the std::stack interface that the iterators use.
+    template <typename U, size_t N>
+    class SmallStack
+    {
+        static_assert(std::is_trivially_copyable<U>::value, "SmallStack holds plain values such as node pointers");
+
+    private:
+        std::pmr::memory_resource *resource; // Where the spilled items are allocated
+        U *spilled;                          // Heap storage once the stack outgrew `local`, nullptr otherwise
+        size_t count;                        // Number of items on the stack
+        size_t spilledCapacity;              // Number of items `spilled` can hold
+        U local[N];                          // Inline storage, used while count <= N
+
+        U *items()
+        {
+            return spilled ? spilled : local;
+        }
+
+        const U *items() const
+        {
+            return spilled ? spilled : local;
+        }
+
+        size_t capacity() const
+        {
+            return spilled ? spilledCapacity : N;
+        }
+
+        void release()
+        {
+            if (spilled)
+            {
+                resource->deallocate(spilled, spilledCapacity * sizeof(U), alignof(U));
+                spilled = nullptr;
+                spilledCapacity = 0;
+            }
+        }
+
+        // Make room for at least `needed` items, keeping the current ones
+        void reserve(size_t needed)
+        {
+            if (needed <= capacity())
+            {
+                return;
+            }
+            size_t newCapacity = std::max(needed, capacity() * 2);
+            U *grown = static_cast<U *>(resource->allocate(newCapacity * sizeof(U), alignof(U)));
+            std::copy(items(), items() + count, grown);
+            release();
+            spilled = grown;
+            spilledCapacity = newCapacity;
+        }
+
+        void copy_from(const SmallStack &other)
+        {
+            count = 0;
+            reserve(other.count);
+            std::copy(other.items(), other.items() + other.count, items());
+            count = other.count;
+        }
+
+    public:
+        typedef U value_type;
+
+        explicit SmallStack(std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), spilled(nullptr), count(0), spilledCapacity(0)
+        {
+        }
+
+        SmallStack(const SmallStack &other)
+            : SmallStack(other, other.resource)
+        {
+        }
+
+        // Copy that allocates (only if it has to) from the given resource
+        SmallStack(const SmallStack &other, std::pmr::memory_resource *res)
+            : resource(res), spilled(nullptr), count(0), spilledCapacity(0)
+        {
+            copy_from(other);
+        }
+
+        // Same resource, so this never allocates
+        SmallStack(SmallStack &&other) noexcept
+            : resource(other.resource), spilled(nullptr), count(0), spilledCapacity(0)
+        {
+            *this = std::move(other);
+        }
+
+        // Assignment keeps this stack's resource, like the std::pmr containers
+        SmallStack &operator=(const SmallStack &other)
+        {
+            if (this != &other)
+            {
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        SmallStack &operator=(SmallStack &&other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+            if (other.spilled && *other.resource == *resource)
+            {
+                // Take over the heap storage instead of copying it
+                release();
+                spilled = other.spilled;
+                spilledCapacity = other.spilledCapacity;
+                count = other.count;
+                other.spilled = nullptr;
+                other.spilledCapacity = 0;
+            }
+            else
+            {
+                copy_from(other);
+            }
+            other.count = 0;
+            return *this;
+        }
+
+        ~SmallStack()
+        {
+            release();
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        U &top()
+        {
+            return items()[count - 1];
+        }
+
+        const U &top() const
+        {
+            return items()[count - 1];
+        }
+
+        void push(const U &item)
+        {
+            if (count == capacity())
+            {
+                reserve(count + 1);
+            }
+            items()[count++] = item;
+        }
+
+        void pop()
+        {
+            --count;
+        }
+
+        // True once the stack has outgrown its inline storage
+        bool is_spilled() const
+        {
+            return spilled != nullptr;
+        }
+    };
+}
+
+#endif
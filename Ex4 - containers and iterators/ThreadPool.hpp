@@ -0,0 +1,239 @@
+/**
+ * Name: Aharon bassous
+ * Email: Aharonba123@gmail.com
+ */
+
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ariel
+{
+    // Work-stealing thread pool. Every worker has its own task deque: tasks a worker
+    // spawns go to the back of its deque and it takes its next task from the back
+    // (the most recent, still in cache), while idle workers steal from the front of
+    // other deques (the oldest tasks, which in a tree walk are the biggest subtrees).
+    // Tasks are grouped in a TaskGroup so a caller can wait for the ones it started;
+    // a waiting thread runs queued tasks (its own first, then stolen ones) instead of
+    // blocking, so tasks may start nested work and wait for it without deadlocking
+    // the pool. When there is nothing to run it sleeps until a task is queued or its
+    // group finishes, rather than spinning.
+    class ThreadPool
+    {
+    public:
+        // Tasks started together; wait() returns once all of them finished
+        class TaskGroup
+        {
+        private:
+            friend class ThreadPool;
+
+            std::atomic<size_t> pending; // Tasks started and not finished yet
+            std::mutex errorLock;
+            std::exception_ptr error; // First exception thrown by a task
+
+        public:
+            TaskGroup() : pending(0) {}
+            TaskGroup(const TaskGroup &) = delete;
+            TaskGroup &operator=(const TaskGroup &) = delete;
+        };
+
+    private:
+        struct Task
+        {
+            std::function<void()> work;
+            TaskGroup *group;
+        };
+
+        struct Worker
+        {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> queued;    // Tasks sitting in the deques
+        std::atomic<size_t> nextQueue; // Round robin for tasks started outside the pool
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        bool stopping;
+
+        // Index of the calling thread in this pool, or workers.size() for other threads
+        size_t self() const
+        {
+            return current().first == this ? current().second : workers.size();
+        }
+
+        static std::pair<const ThreadPool *, size_t> &current()
+        {
+            thread_local std::pair<const ThreadPool *, size_t> worker(nullptr, 0);
+            return worker;
+        }
+
+        // Own deque from the back, then the others from the front
+        bool take(size_t index, Task &task)
+        {
+            if (index < workers.size())
+            {
+                Worker &own = *workers[index];
+                std::lock_guard<std::mutex> guard(own.lock);
+                if (!own.tasks.empty())
+                {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    queued.fetch_sub(1);
+                    return true;
+                }
+            }
+            for (size_t i = 1; i <= workers.size(); ++i)
+            {
+                Worker &victim = *workers[(index + i) % workers.size()];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.tasks.empty())
+                {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    queued.fetch_sub(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void execute(Task &task)
+        {
+            try
+            {
+                task.work();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(task.group->errorLock);
+                if (!task.group->error)
+                    task.group->error = std::current_exception();
+            }
+            if (task.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                // Last task of the group: wake the threads sleeping in wait()
+                {
+                    std::lock_guard<std::mutex> guard(sleepLock);
+                }
+                wake.notify_all();
+            }
+        }
+
+        void work(size_t index)
+        {
+            current() = std::make_pair(this, index);
+            Task task;
+            while (true)
+            {
+                if (take(index, task))
+                {
+                    execute(task);
+                    continue;
+                }
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+                if (stopping && queued.load() == 0)
+                    return;
+            }
+        }
+
+    public:
+        // count == 0 starts one thread per hardware thread
+        explicit ThreadPool(size_t count = 0)
+            : queued(0), nextQueue(0), stopping(false)
+        {
+            if (count == 0)
+                count = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < count; ++i)
+                workers.push_back(std::make_unique<Worker>());
+            for (size_t i = 0; i < count; ++i)
+                threads.emplace_back([this, i] { work(i); });
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // Finishes the queued tasks, then joins the workers
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &thread : threads)
+                thread.join();
+        }
+
+        // Pool used by Tree::parallel_for_each when none is given
+        static ThreadPool &shared()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        size_t size() const
+        {
+            return workers.size();
+        }
+
+        // Queue a task in the group. From a worker it goes to that worker's deque.
+        void run(TaskGroup &group, std::function<void()> work)
+        {
+            group.pending.fetch_add(1);
+            size_t index = self();
+            if (index == workers.size())
+                index = nextQueue.fetch_add(1) % workers.size();
+            {
+                std::lock_guard<std::mutex> guard(workers[index]->lock);
+                workers[index]->tasks.push_back(Task{std::move(work), &group});
+            }
+            queued.fetch_add(1);
+            {
+                // Taking the lock orders this with a worker about to sleep
+                std::lock_guard<std::mutex> guard(sleepLock);
+            }
+            wake.notify_one();
+        }
+
+        // Run queued tasks until every task of the group finished, then rethrow the
+        // first exception one of them threw. With nothing to run, sleep until a task
+        // is queued or the group's last task finishes.
+        void wait(TaskGroup &group)
+        {
+            size_t index = self();
+            Task task;
+            while (group.pending.load(std::memory_order_acquire) > 0)
+            {
+                if (take(index, task))
+                {
+                    execute(task);
+                    continue;
+                }
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait(guard, [this, &group]
+                          { return group.pending.load(std::memory_order_acquire) == 0 || queued.load() > 0; });
+            }
+            if (group.error)
+                std::rethrow_exception(std::exchange(group.error, nullptr));
+        }
+    };
+}
+
+#endif
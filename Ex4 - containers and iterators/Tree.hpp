@@ -9,25 +9,412 @@
 
 #include <stdexcept>
 #include <stack>
+#include <algorithm>
+#include <iterator>
 #include <queue>
+#include <span>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <SFML/Graphics.hpp> 
 #include <stdexcept>
+#include "ConcurrentNode.hpp"
+#include "Generator.hpp"
 #include "Node.hpp"
+#include "NodeArena.hpp"
+#include "ThreadPool.hpp"
 #include "TreeIterators.hpp"
 
 using namespace std;
 
 namespace ariel
 {
-    template <typename T, size_t K = 2>
+    // Memory layout of the block produced by Tree::freeze()
+    enum class FreezeLayout
+    {
+        BreadthFirst, // Level by level (any tree)
+        VanEmdeBoas   // Recursive cache-oblivious layout (binary trees)
+    };
+
+    // Order of the values produced by Tree::traverse()
+    enum class TraversalOrder
+    {
+        PreOrder,
+        InOrder, // Pre-order on trees that are not binary, like InOrderIterator
+        PostOrder,
+        BreadthFirst
+    };
+
+    // Nodes a parallel_for_each task visits before it hands part of its work to the pool
+    const size_t PARALLEL_GRAIN = 4096;
+
+    template <typename T, size_t K = 2, typename NodeT = Node<T>>
     class Tree
     {
     private:
-        Node<T> *root;
+        typedef std::pmr::vector<size_t> IndexList;
+        typedef std::pmr::vector<NodeT *> NodeList;
+
+        std::pmr::memory_resource *resource; // Where the tree, its nodes and its iterators allocate
+        NodeT *root;
         bool isBinary;
+        NodeArena<NodeT> arena;              // Storage for nodes created through emplace_root/emplace_child
+        std::pmr::vector<NodeT> frozenNodes; // Read-only copy of the tree (see freeze())
+        bool frozen;
+        FreezeLayout frozenLayout;
+        std::pmr::vector<NodeT *> heapOrder; // Nodes in level order, as walked by the iterator from myHeap()
+        std::pmr::vector<T> heapValues;      // Implicit array heap built by myHeap() for complete trees
+
+        static constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+        // Height (number of levels) of a tree given in BFS-numbered child slots
+        static size_t tree_height(const IndexList &slots, const IndexList &slotBegin)
+        {
+            size_t nodes = slotBegin.size() - 1;
+            IndexList depth(nodes, 0, slots.get_allocator());
+            size_t height = nodes ? 1 : 0;
+            for (size_t i = 0; i < nodes; ++i) // Parents come before children in BFS order
+            {
+                for (size_t s = slotBegin[i]; s < slotBegin[i + 1]; ++s)
+                {
+                    if (slots[s] != NO_NODE)
+                    {
+                        depth[slots[s]] = depth[i] + 1;
+                        height = std::max(height, depth[i] + 2);
+                    }
+                }
+            }
+            return height;
+        }
+
+        // Append the van Emde Boas order of the subtree rooted at `node`, limited to
+        // `height` levels: the top half of the levels first, then each bottom subtree.
+        // `scratch` holds the frontier of every active call (a stack of ranges).
+        static void veb_order(size_t node, size_t height, const IndexList &slots,
+                              const IndexList &slotBegin, IndexList &scratch,
+                              IndexList &order)
+        {
+            if (height == 1)
+            {
+                order.push_back(node);
+                return;
+            }
+            size_t top = height / 2;
+            size_t bottom = height - top;
+            veb_order(node, top, slots, slotBegin, scratch, order);
+
+            // Find the roots of the bottom subtrees: the descendants `top` levels down
+            size_t mark = scratch.size();
+            size_t levelBegin = mark;
+            scratch.push_back(node);
+            for (size_t level = 0; level < top; ++level)
+            {
+                size_t levelEnd = scratch.size();
+                for (size_t i = levelBegin; i < levelEnd; ++i)
+                {
+                    size_t current = scratch[i];
+                    for (size_t s = slotBegin[current]; s < slotBegin[current + 1]; ++s)
+                    {
+                        if (slots[s] != NO_NODE)
+                            scratch.push_back(slots[s]);
+                    }
+                }
+                levelBegin = levelEnd;
+            }
+
+            size_t levelEnd = scratch.size();
+            for (size_t i = levelBegin; i < levelEnd; ++i)
+            {
+                veb_order(scratch[i], bottom, slots, slotBegin, scratch, order);
+            }
+            scratch.resize(mark);
+        }
+
+        // Nodes are given the tree's memory resource when their type accepts one
+        static constexpr bool NODE_USES_RESOURCE = std::is_constructible<NodeT, const T &, std::pmr::memory_resource *>::value;
+
+        // Construct a node in the tree's arena
+        template <typename... Args>
+        NodeT *create_node(Args &&...args)
+        {
+            if constexpr (NODE_USES_RESOURCE)
+                return arena.create(std::forward<Args>(args)..., resource);
+            else
+                return arena.create(std::forward<Args>(args)...);
+        }
+
+        void check_mutable() const
+        {
+            if (frozen)
+                throw std::logic_error("The tree is frozen.");
+        }
+
+        // Call visit on a node's value; false means the visitor asked to stop.
+        // Visitors returning void never stop the walk.
+        template <typename F>
+        static bool visit_value(F &visit, NodeT *node)
+        {
+            if constexpr (std::is_void_v<std::invoke_result_t<F &, T &>>)
+            {
+                visit(node->value);
+                return true;
+            }
+            else
+            {
+                return static_cast<bool>(visit(node->value));
+            }
+        }
+
+        void check_bfs_frozen() const
+        {
+            if (!frozen || frozenLayout != FreezeLayout::BreadthFirst)
+                throw std::logic_error("Reverse BFS needs a tree frozen in BFS order.");
+        }
+
+        // Coroutine bodies behind traverse(). V and N are T and NodeT, or their const
+        // versions. Each is the loop of the matching for_each_*, with co_yield in place
+        // of the visitor call; the stack or queue lives in the coroutine frame.
+        template <typename V, typename N>
+        static Generator<V> generate_pre_order(N *start, std::pmr::memory_resource *res)
+        {
+            ResourceStack<N *> stk(res);
+            if (start)
+                stk.push(start);
+            while (!stk.empty())
+            {
+                N *node = stk.top();
+                stk.pop();
+                for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                {
+                    if (*it)
+                        stk.push(*it);
+                }
+                co_yield node->value;
+            }
+        }
+
+        template <typename V, typename N>
+        static Generator<V> generate_in_order(N *start, std::pmr::memory_resource *res)
+        {
+            ResourceStack<N *> stk(res);
+            N *node = start;
+            while (node || !stk.empty())
+            {
+                while (node)
+                {
+                    stk.push(node);
+                    node = node->children.size() > 0 ? node->children[0] : nullptr;
+                }
+                node = stk.top();
+                stk.pop();
+                co_yield node->value;
+                node = node->children.size() > 1 ? node->children[1] : nullptr;
+            }
+        }
+
+        template <typename V, typename N>
+        static Generator<V> generate_post_order(N *start, bool binary, std::pmr::memory_resource *res)
+        {
+            struct Frame
+            {
+                N *node;
+                size_t next;
+            };
+            ResourceStack<Frame> stk(res);
+            if (start)
+                stk.push(Frame{start, 0});
+            while (!stk.empty())
+            {
+                Frame &top = stk.top();
+                size_t limit = binary ? std::min<size_t>(top.node->children.size(), 2) : top.node->children.size();
+                if (top.next < limit)
+                {
+                    N *child = top.node->children[top.next++];
+                    if (child)
+                        stk.push(Frame{child, 0});
+                }
+                else
+                {
+                    N *node = top.node;
+                    stk.pop();
+                    co_yield node->value;
+                }
+            }
+        }
+
+        // first..last is a block frozen in BFS order (walked linearly), or empty
+        template <typename V, typename N>
+        static Generator<V> generate_bfs(N *start, N *first, N *last, std::pmr::memory_resource *res)
+        {
+            if (first != last)
+            {
+                for (N *node = first; node != last; ++node)
+                    co_yield node->value;
+                co_return;
+            }
+
+            ResourceQueue<N *> q(res);
+            if (start)
+                q.push(start);
+            while (!q.empty())
+            {
+                N *node = q.front();
+                q.pop();
+                for (auto child : node->children)
+                {
+                    if (child)
+                        q.push(child);
+                }
+                co_yield node->value;
+            }
+        }
+
+        template <typename V, typename N>
+        static Generator<V> generate(TraversalOrder order, N *start, bool binary, N *frozenFirst, N *frozenLast,
+                                     std::pmr::memory_resource *res)
+        {
+            switch (order)
+            {
+            case TraversalOrder::InOrder:
+                if (K == 2)
+                    return generate_in_order<V>(start, res);
+                return generate_pre_order<V>(start, res);
+            case TraversalOrder::PostOrder:
+                return generate_post_order<V>(start, binary, res);
+            case TraversalOrder::BreadthFirst:
+                return generate_bfs<V>(start, frozenFirst, frozenLast, res);
+            default:
+                return generate_pre_order<V>(start, res);
+            }
+        }
+
+        // One parallel_for_each task: a DFS of the subtree at start. Every `grain` nodes
+        // the oldest entry still on the stack, the shallowest and so usually the largest
+        // pending subtree, is handed to the pool as a new task. A subtree smaller than
+        // the grain is never split. Each task's stack is allocated from res.
+        template <typename F>
+        static void parallel_walk(NodeT *start, F &visit, size_t grain, ThreadPool &pool, ThreadPool::TaskGroup &group,
+                                  std::pmr::memory_resource *res)
+        {
+            std::pmr::vector<NodeT *> stk({start}, res);
+            size_t bottom = 0; // stk[bottom..] are the entries still to visit here
+            size_t sinceSplit = 0;
+            while (stk.size() > bottom)
+            {
+                NodeT *node = stk.back();
+                stk.pop_back();
+                visit(node->value);
+                for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                {
+                    if (*it)
+                        stk.push_back(*it);
+                }
+                if (++sinceSplit >= grain && stk.size() - bottom > 1)
+                {
+                    NodeT *split = stk[bottom++];
+                    pool.run(group, [split, &visit, grain, &pool, &group, res]
+                             { parallel_walk(split, visit, grain, pool, group, res); });
+                    sinceSplit = 0;
+                }
+            }
+        }
+
+        // Calls work(begin, end) for consecutive chunks of at most `grain` of the
+        // indices 0..size-1, on the pool, and waits for them. A single chunk runs on
+        // the calling thread.
+        template <typename W>
+        static void for_chunks(size_t size, W &work, size_t grain, ThreadPool &pool)
+        {
+            size_t chunks = (size + grain - 1) / grain;
+            if (chunks <= 1)
+            {
+                work(0, size);
+                return;
+            }
+            ThreadPool::TaskGroup group;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                pool.run(group, [&work, c, grain, size]
+                         { work(c * grain, std::min(size, (c + 1) * grain)); });
+            }
+            pool.wait(group);
+        }
+
+        // One step of the level-synchronous walks: calls visit(value) for the nodes of
+        // `level` and replaces `next` with their non-null children, in BFS order. Chunks
+        // of the level first visit and count their children in parallel; a prefix sum
+        // over the counts then gives each chunk its place in `next`, where it copies its
+        // children, so no locks or per-chunk buffers are needed. If firstChild is given
+        // (level.size() + 1 entries), the children of level[i] end up at
+        // next[firstChild[i] .. firstChild[i + 1]). Scratch space comes from next's
+        // memory resource.
+        template <typename F>
+        static void expand_level(std::span<NodeT *const> level, NodeList &next, size_t *firstChild,
+                                 F &visit, size_t grain, ThreadPool &pool)
+        {
+            if (level.empty())
+            {
+                next.clear();
+                return;
+            }
+            size_t chunks = (level.size() + grain - 1) / grain;
+            IndexList offsets(chunks + 1, 0, next.get_allocator());
+            auto count = [&](size_t begin, size_t end)
+            {
+                size_t children = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    visit(level[i]->value);
+                    for (auto child : level[i]->children)
+                        children += child != nullptr;
+                }
+                offsets[begin / grain + 1] = children;
+            };
+            for_chunks(level.size(), count, grain, pool);
+            for (size_t c = 0; c < chunks; ++c)
+                offsets[c + 1] += offsets[c];
+
+            next.resize(offsets[chunks]);
+            auto place = [&](size_t begin, size_t end)
+            {
+                size_t out = offsets[begin / grain];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    if (firstChild)
+                        firstChild[i] = out;
+                    for (auto child : level[i]->children)
+                    {
+                        if (child)
+                            next[out++] = child;
+                    }
+                }
+                if (firstChild && end == level.size())
+                    firstChild[end] = out;
+            };
+            for_chunks(level.size(), place, grain, pool);
+        }
+
+        void check_parent(NodeT *parent) const
+        {
+            check_mutable();
+            if (!parent)
+                throw std::invalid_argument("Parent node cannot be null.");
+            if (parent->children.size() >= K)
+                throw std::overflow_error("Maximum number of children reached.");
+        }
 
     public:
-        Tree() : root(nullptr)
+        Tree() : Tree(std::pmr::get_default_resource())
+        {
+        }
+
+        // Every allocation made by the tree, its nodes (emplace_root/emplace_child,
+        // freeze) and the iterators it returns comes from `res`
+        explicit Tree(std::pmr::memory_resource *res)
+            : resource(res), root(nullptr), arena(res), frozenNodes(res), frozen(false),
+              frozenLayout(FreezeLayout::BreadthFirst), heapOrder(res), heapValues(res)
         {
             if (K == 2)
             {
@@ -39,106 +426,784 @@ namespace ariel
             }
         }
 
+        // Trees are not copied implicitly: use clone() for a deep copy
+        Tree(const Tree &) = delete;
+        Tree &operator=(const Tree &) = delete;
+
+        // O(1): takes over the other tree's nodes, frozen block and heap state.
+        // The other tree is left empty; pointers into the nodes stay valid.
+        Tree(Tree &&other) noexcept
+            : resource(other.resource), root(other.root), isBinary(other.isBinary), arena(std::move(other.arena)),
+              frozenNodes(std::move(other.frozenNodes)), frozen(other.frozen), frozenLayout(other.frozenLayout),
+              heapOrder(std::move(other.heapOrder)), heapValues(std::move(other.heapValues))
+        {
+            other.root = nullptr;
+            other.frozen = false;
+            other.frozenNodes.clear();
+            other.heapOrder.clear();
+            other.heapValues.clear();
+        }
+
+        // Releases this tree's nodes, then takes over the other tree (and its memory
+        // resource) in O(1). The tree is rebuilt in place because pmr containers
+        // cannot switch memory resources by assignment.
+        Tree &operator=(Tree &&other) noexcept
+        {
+            if (this != &other)
+            {
+                std::destroy_at(this);
+                std::construct_at(this, std::move(other));
+            }
+            return *this;
+        }
+
+        // Deep copy of every node reachable from the root into the new tree's own arena,
+        // built in one BFS pass (no recursion). The copy is not frozen.
+        Tree clone() const
+        {
+            return clone(resource);
+        }
+
+        Tree clone(std::pmr::memory_resource *res) const
+        {
+            Tree copy(res);
+            if (!root)
+                return copy;
+
+            // Pairs of (source node, its copy) whose children still have to be copied
+            std::pmr::vector<std::pair<const NodeT *, NodeT *>> pending(res);
+            copy.root = copy.create_node(root->value);
+            pending.emplace_back(root, copy.root);
+            for (size_t i = 0; i < pending.size(); ++i)
+            {
+                const NodeT *source = pending[i].first;
+                NodeT *target = pending[i].second;
+                for (auto child : source->children)
+                {
+                    NodeT *childCopy = child ? copy.create_node(child->value) : nullptr;
+                    target->add_child(childCopy);
+                    if (child)
+                        pending.emplace_back(child, childCopy);
+                }
+            }
+            return copy;
+        }
+
+        // Release every node the tree owns in one step (slab by slab, no recursion)
+        // and leave the tree empty and unfrozen
+        void clear()
+        {
+            root = nullptr;
+            frozen = false;
+            frozenNodes.clear();
+            heapOrder.clear();
+            heapValues.clear();
+            arena.clear();
+        }
+
         bool is_binary() const
         {
             return isBinary;
         }
 
-        void add_root(Node<T> *newRoot)
+        void add_root(NodeT *newRoot)
         {
+            check_mutable();
             root = newRoot;
         }
 
-        void add_sub_node(Node<T> *parent, Node<T> *son)
+        void add_sub_node(NodeT *parent, NodeT *son)
         {
-            if (!parent)
-                throw std::invalid_argument("Parent node cannot be null.");
-            if (parent->children.size() > K)
-                throw std::overflow_error("Maximum number of children reached.");
+            check_parent(parent);
             parent->add_child(son);
         }
 
-        Node<T> *get_root() const
+        // Create the root node inside the tree's arena; the tree owns it
+        template <typename... Args>
+        NodeT *emplace_root(Args &&...args)
         {
+            check_mutable();
+            root = create_node(std::forward<Args>(args)...);
             return root;
         }
 
+        // Create a child of parent inside the tree's arena; the tree owns it
+        template <typename... Args>
+        NodeT *emplace_child(NodeT *parent, Args &&...args)
+        {
+            check_parent(parent);
+            NodeT *child = create_node(std::forward<Args>(args)...);
+            parent->add_child(child);
+            return child;
+        }
+
+        // Number of nodes owned by the tree (created through emplace_root/emplace_child)
+        size_t owned_nodes() const
+        {
+            return arena.size();
+        }
+
+        NodeT *get_root() const
+        {
+            return root;
+        }
+
+        std::pmr::memory_resource *get_resource() const
+        {
+            return resource;
+        }
+
+        // Copy the tree into one contiguous block and make every traversal run over
+        // that copy. The tree cannot be modified structurally afterwards; values can
+        // still be changed through iterators (they change the frozen copy).
+        //
+        // BreadthFirst: the block is in BFS order. Siblings end up next to each other,
+        //   so the children of a node form one contiguous range of the block, and the
+        //   BFS scan becomes a linear walk.
+        // VanEmdeBoas (binary trees only): the block is in recursive van Emde Boas
+        //   order, so a root-to-leaf path touches O(log_B n) cache lines for any cache
+        //   line size B. The BFS scan falls back to the queue-based walk.
+        void freeze(FreezeLayout layout = FreezeLayout::BreadthFirst)
+        {
+            if (layout == FreezeLayout::VanEmdeBoas && !isBinary)
+                throw std::logic_error("The van Emde Boas layout requires a binary tree.");
+
+            // Number the nodes in BFS order and record where each one's children are
+            std::pmr::vector<NodeT *> bfs(resource);
+            IndexList slots(resource);     // Child BFS numbers (NO_NODE for null children)
+            IndexList slotBegin(resource); // Children of bfs[i] are slots[slotBegin[i] .. slotBegin[i + 1])
+            if (root)
+            {
+                bfs.push_back(root);
+            }
+            for (size_t i = 0; i < bfs.size(); ++i)
+            {
+                slotBegin.push_back(slots.size());
+                for (auto child : bfs[i]->children)
+                {
+                    if (child)
+                    {
+                        slots.push_back(bfs.size());
+                        bfs.push_back(child);
+                    }
+                    else
+                    {
+                        slots.push_back(NO_NODE);
+                    }
+                }
+            }
+            slotBegin.push_back(slots.size());
+
+            // order[b] is the BFS number of the node stored at block position b
+            IndexList order(resource);
+            if (layout == FreezeLayout::VanEmdeBoas && !bfs.empty())
+            {
+                order.reserve(bfs.size());
+                IndexList scratch(resource);
+                veb_order(0, tree_height(slots, slotBegin), slots, slotBegin, scratch, order);
+            }
+            else
+            {
+                for (size_t i = 0; i < bfs.size(); ++i)
+                {
+                    order.push_back(i);
+                }
+            }
+
+            IndexList position(bfs.size(), 0, resource); // Inverse of order
+            std::pmr::vector<NodeT> block(resource);
+            block.reserve(bfs.size()); // No reallocation: pointers into the block stay valid
+            for (size_t b = 0; b < order.size(); ++b)
+            {
+                position[order[b]] = b;
+                if constexpr (NODE_USES_RESOURCE)
+                    block.emplace_back(bfs[order[b]]->value, resource);
+                else
+                    block.emplace_back(bfs[order[b]]->value);
+            }
+            for (size_t b = 0; b < order.size(); ++b)
+            {
+                size_t node = order[b];
+                for (size_t s = slotBegin[node]; s < slotBegin[node + 1]; ++s)
+                {
+                    block[b].add_child(slots[s] == NO_NODE ? nullptr : &block[position[slots[s]]]);
+                }
+            }
+
+            frozenNodes.swap(block);
+            root = frozenNodes.empty() ? nullptr : &frozenNodes[0];
+            frozen = true;
+            frozenLayout = layout;
+        }
+
+        bool is_frozen() const
+        {
+            return frozen;
+        }
+
 
         // Return an iterator to the beginning of the tree (pre-order)
-        PreOrderIterator<T> begin_pre_order()
+        PreOrderIterator<T, NodeT> begin_pre_order()
         {
-            return PreOrderIterator<T>(root, this->is_binary());
+            return PreOrderIterator<T, NodeT>(root, this->is_binary(), resource);
         }
 
         // Return an iterator to the end of the tree (pre-order)
-        PreOrderIterator<T> end_pre_order()
+        PreOrderIterator<T, NodeT> end_pre_order()
         {
-            return PreOrderIterator<T>(nullptr, this->is_binary());
+            return PreOrderIterator<T, NodeT>(nullptr, this->is_binary(), resource);
         }
 
         // Return an iterator to the beginning of the tree (post-order)
-        PostOrderIterator<T> begin_post_order()
+        PostOrderIterator<T, NodeT> begin_post_order()
         {
-            return PostOrderIterator<T>(root, this->is_binary());
+            return PostOrderIterator<T, NodeT>(root, this->is_binary(), resource);
         }
 
         // Return an iterator to the end of the tree (post-order)
-        PostOrderIterator<T> end_post_order()
+        PostOrderIterator<T, NodeT> end_post_order()
         {
-            return PostOrderIterator<T>(nullptr, this->is_binary());
+            return PostOrderIterator<T, NodeT>(nullptr, this->is_binary(), resource);
         }
 
         // Return an iterator to the beginning of the tree (in-order)
-        InOrderIterator<T> begin_in_order()
+        InOrderIterator<T, NodeT> begin_in_order()
         {
-            return InOrderIterator<T>(root, K == 2);
+            return InOrderIterator<T, NodeT>(root, K == 2, resource);
         }
 
         // Return an iterator to the end of the tree (in-order)
-        InOrderIterator<T> end_in_order()
+        InOrderIterator<T, NodeT> end_in_order()
         {
-            return InOrderIterator<T>(nullptr, K == 2);
+            return InOrderIterator<T, NodeT>(nullptr, K == 2, resource);
         }
 
         // Function to return a BFS iterator pointing to the beginning of the BFS scan
-        BFSIterator<T> begin_bfs_scan()
+        BFSIterator<T, NodeT> begin_bfs_scan()
+        {
+            if (frozen && frozenLayout == FreezeLayout::BreadthFirst)
+            {
+                // The frozen block is already in BFS order: walk it linearly
+                return BFSIterator<T, NodeT>(frozenNodes.data(), frozenNodes.data() + frozenNodes.size(), resource);
+            }
+            return BFSIterator<T, NodeT>(root, resource); 
+        }
+
+        // BFS scan that prefetches the node `prefetchDistance` places ahead in the queue.
+        // Worth it on big trees whose nodes are scattered in memory; a BFS-frozen tree is
+        // walked linearly and ignores the distance
+        BFSIterator<T, NodeT> begin_bfs_scan(size_t prefetchDistance)
         {
-            return BFSIterator<T>(root); 
+            BFSIterator<T, NodeT> it = begin_bfs_scan();
+            it.set_prefetch_distance(prefetchDistance);
+            return it;
         }
 
         // Function to return a BFS iterator pointing to the end of the BFS scan
-        BFSIterator<T> end_bfs_scan()
+        BFSIterator<T, NodeT> end_bfs_scan()
         {
-            return BFSIterator<T>(nullptr); 
+            return BFSIterator<T, NodeT>(nullptr, resource); 
         }
 
         // Begin iterator for DFS scan
-        DFSIterator<T> begin_dfs_scan()
+        DFSIterator<T, NodeT> begin_dfs_scan()
         {
-            return DFSIterator<T>(root); 
+            return DFSIterator<T, NodeT>(root, resource); 
         }
 
         // End iterator for DFS scan
-        DFSIterator<T> end_dfs_scan()
+        DFSIterator<T, NodeT> end_dfs_scan()
         {
-            return DFSIterator<T>(nullptr); 
+            return DFSIterator<T, NodeT>(nullptr, resource); 
         }
 
-        // Function to heapify a subtree rooted at node i
-        void heapify(Node<T> *node)
+        // Ranges over the traversals, for range-for and the standard algorithms. The
+        // const overloads iterate over const nodes and give read-only values.
+        TraversalRange<PreOrderIterator<T, NodeT>> pre_order()
         {
-            Node<T> *smallest = node;
+            return TraversalRange<PreOrderIterator<T, NodeT>>(begin_pre_order(), end_pre_order());
+        }
 
-            // Check left child
-            if (node->children.size() > 0 && node->children[0]->value < smallest->value)
+        TraversalRange<PreOrderIterator<const T, const NodeT>> pre_order() const
+        {
+            typedef PreOrderIterator<const T, const NodeT> It;
+            return TraversalRange<It>(It(root, isBinary, resource), It(nullptr, isBinary, resource));
+        }
+
+        TraversalRange<InOrderIterator<T, NodeT>> in_order()
+        {
+            return TraversalRange<InOrderIterator<T, NodeT>>(begin_in_order(), end_in_order());
+        }
+
+        TraversalRange<InOrderIterator<const T, const NodeT>> in_order() const
+        {
+            typedef InOrderIterator<const T, const NodeT> It;
+            return TraversalRange<It>(It(root, K == 2, resource), It(nullptr, K == 2, resource));
+        }
+
+        TraversalRange<PostOrderIterator<T, NodeT>> post_order()
+        {
+            return TraversalRange<PostOrderIterator<T, NodeT>>(begin_post_order(), end_post_order());
+        }
+
+        TraversalRange<PostOrderIterator<const T, const NodeT>> post_order() const
+        {
+            typedef PostOrderIterator<const T, const NodeT> It;
+            return TraversalRange<It>(It(root, isBinary, resource), It(nullptr, isBinary, resource));
+        }
+
+        TraversalRange<BFSIterator<T, NodeT>> bfs_scan()
+        {
+            return TraversalRange<BFSIterator<T, NodeT>>(begin_bfs_scan(), end_bfs_scan());
+        }
+
+        TraversalRange<BFSIterator<const T, const NodeT>> bfs_scan() const
+        {
+            typedef BFSIterator<const T, const NodeT> It;
+            if (frozen && frozenLayout == FreezeLayout::BreadthFirst)
+            {
+                return TraversalRange<It>(It(frozenNodes.data(), frozenNodes.data() + frozenNodes.size(), resource), It(nullptr, resource));
+            }
+            return TraversalRange<It>(It(root, resource), It(nullptr, resource));
+        }
+
+        TraversalRange<DFSIterator<T, NodeT>> dfs_scan()
+        {
+            return TraversalRange<DFSIterator<T, NodeT>>(begin_dfs_scan(), end_dfs_scan());
+        }
+
+        TraversalRange<DFSIterator<const T, const NodeT>> dfs_scan() const
+        {
+            typedef DFSIterator<const T, const NodeT> It;
+            return TraversalRange<It>(It(root, resource), It(nullptr, resource));
+        }
+
+        // Stackless traversals: the iterators hold just two pointers and never allocate.
+        // Only available when the nodes keep parent links (see ParentTree). They are
+        // bidirectional, and the end iterators can be decremented to the last node.
+        StacklessPreOrderIterator<T, NodeT> begin_pre_order_stackless()
+        {
+            return StacklessPreOrderIterator<T, NodeT>(root);
+        }
+
+        StacklessPreOrderIterator<T, NodeT> end_pre_order_stackless()
+        {
+            return StacklessPreOrderIterator<T, NodeT>(root, nullptr);
+        }
+
+        StacklessPostOrderIterator<T, NodeT> begin_post_order_stackless()
+        {
+            return StacklessPostOrderIterator<T, NodeT>(root);
+        }
+
+        StacklessPostOrderIterator<T, NodeT> end_post_order_stackless()
+        {
+            return StacklessPostOrderIterator<T, NodeT>(root, nullptr);
+        }
+
+        StacklessInOrderIterator<T, NodeT, K == 2> begin_in_order_stackless()
+        {
+            return StacklessInOrderIterator<T, NodeT, K == 2>(root);
+        }
+
+        StacklessInOrderIterator<T, NodeT, K == 2> end_in_order_stackless()
+        {
+            return StacklessInOrderIterator<T, NodeT, K == 2>(root, nullptr);
+        }
+
+        // Reverse scans. Nodes with parent links get std::reverse_iterators over the
+        // stackless iterators; other nodes get the stack-based Reverse*Iterators,
+        // which walk the tree right to left. Either way the first node is found in
+        // O(depth) and each step is O(1) amortized, so reading the last N nodes of an
+        // order costs O(N + depth).
+        auto rbegin_pre_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessPreOrderIterator<T, NodeT>>(end_pre_order_stackless());
+            else
+                return ReversePreOrderIterator<T, NodeT>(root, isBinary, resource);
+        }
+
+        auto rend_pre_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessPreOrderIterator<T, NodeT>>(begin_pre_order_stackless());
+            else
+                return ReversePreOrderIterator<T, NodeT>(nullptr, isBinary, resource);
+        }
+
+        auto rbegin_post_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessPostOrderIterator<T, NodeT>>(end_post_order_stackless());
+            else
+                return ReversePostOrderIterator<T, NodeT>(root, isBinary, resource);
+        }
+
+        auto rend_post_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessPostOrderIterator<T, NodeT>>(begin_post_order_stackless());
+            else
+                return ReversePostOrderIterator<T, NodeT>(nullptr, isBinary, resource);
+        }
+
+        auto rbegin_in_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessInOrderIterator<T, NodeT, K == 2>>(end_in_order_stackless());
+            else
+                return ReverseInOrderIterator<T, NodeT>(root, K == 2, resource);
+        }
+
+        auto rend_in_order()
+        {
+            if constexpr (has_parent_links<NodeT>::value)
+                return std::reverse_iterator<StacklessInOrderIterator<T, NodeT, K == 2>>(begin_in_order_stackless());
+            else
+                return ReverseInOrderIterator<T, NodeT>(nullptr, K == 2, resource);
+        }
+
+        // Reverse BFS walks the frozen block backwards, so the tree must be frozen in
+        // BFS order (any node type)
+        std::reverse_iterator<FrozenBFSIterator<T, NodeT>> rbegin_bfs_scan()
+        {
+            check_bfs_frozen();
+            return std::reverse_iterator<FrozenBFSIterator<T, NodeT>>(FrozenBFSIterator<T, NodeT>(frozenNodes.data() + frozenNodes.size()));
+        }
+
+        std::reverse_iterator<FrozenBFSIterator<T, NodeT>> rend_bfs_scan()
+        {
+            check_bfs_frozen();
+            return std::reverse_iterator<FrozenBFSIterator<T, NodeT>>(FrozenBFSIterator<T, NodeT>(frozenNodes.data()));
+        }
+
+        // Morris (threaded) scans of a binary tree with O(1) extra memory. The tree is
+        // modified while a scan runs and restored when it ends; see MorrisIterator.
+        MorrisInOrderIterator<T, NodeT> begin_in_order_morris()
+        {
+            if (!isBinary)
+                throw std::logic_error("Morris traversal requires a binary tree.");
+            return MorrisInOrderIterator<T, NodeT>(root);
+        }
+
+        MorrisInOrderIterator<T, NodeT> end_in_order_morris()
+        {
+            return MorrisInOrderIterator<T, NodeT>();
+        }
+
+        MorrisPreOrderIterator<T, NodeT> begin_pre_order_morris()
+        {
+            if (!isBinary)
+                throw std::logic_error("Morris traversal requires a binary tree.");
+            return MorrisPreOrderIterator<T, NodeT>(root);
+        }
+
+        MorrisPreOrderIterator<T, NodeT> end_pre_order_morris()
+        {
+            return MorrisPreOrderIterator<T, NodeT>();
+        }
+
+        // Internal traversals: call visit(value) for every node, in the same orders as
+        // the matching iterators. The walk is one loop with its stack (or queue) as a
+        // local variable, so nothing is written back to an iterator between nodes and
+        // visit can be inlined. If visit returns bool, returning false stops the walk.
+        // Each function returns false if it was stopped early, true otherwise.
+        template <typename F>
+        bool for_each_pre_order(F &&visit)
+        {
+            ResourceStack<NodeT *> stk(resource);
+            if (root)
+                stk.push(root);
+            while (!stk.empty())
+            {
+                NodeT *node = stk.top();
+                stk.pop();
+                if (!visit_value(visit, node))
+                    return false;
+                for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                {
+                    if (*it)
+                        stk.push(*it);
+                }
+            }
+            return true;
+        }
+
+        template <typename F>
+        bool for_each_post_order(F &&visit)
+        {
+            // (node, next child to descend into), as in PostOrderIterator
+            struct Frame
+            {
+                NodeT *node;
+                size_t next;
+            };
+            ResourceStack<Frame> stk(resource);
+            if (root)
+                stk.push(Frame{root, 0});
+            while (!stk.empty())
+            {
+                Frame &top = stk.top();
+                size_t limit = isBinary ? std::min<size_t>(top.node->children.size(), 2) : top.node->children.size();
+                if (top.next < limit)
+                {
+                    NodeT *child = top.node->children[top.next++];
+                    if (child)
+                        stk.push(Frame{child, 0});
+                }
+                else
+                {
+                    NodeT *node = top.node;
+                    stk.pop();
+                    if (!visit_value(visit, node))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        // Binary trees: left, current, right. General trees use pre-order, like InOrderIterator.
+        template <typename F>
+        bool for_each_in_order(F &&visit)
+        {
+            if (K != 2)
+                return for_each_pre_order(std::forward<F>(visit));
+
+            ResourceStack<NodeT *> stk(resource);
+            NodeT *node = root;
+            while (node || !stk.empty())
+            {
+                while (node)
+                {
+                    stk.push(node);
+                    node = node->children.size() > 0 ? node->children[0] : nullptr;
+                }
+                node = stk.top();
+                stk.pop();
+                if (!visit_value(visit, node))
+                    return false;
+                node = node->children.size() > 1 ? node->children[1] : nullptr;
+            }
+            return true;
+        }
+
+        template <typename F>
+        bool for_each_bfs(F &&visit)
+        {
+            if (frozen && frozenLayout == FreezeLayout::BreadthFirst)
+            {
+                // The frozen block is already in BFS order
+                for (NodeT &node : frozenNodes)
+                {
+                    if (!visit_value(visit, &node))
+                        return false;
+                }
+                return true;
+            }
+
+            ResourceQueue<NodeT *> q(resource);
+            if (root)
+                q.push(root);
+            while (!q.empty())
+            {
+                NodeT *node = q.front();
+                q.pop();
+                if (!visit_value(visit, node))
+                    return false;
+                for (auto child : node->children)
+                {
+                    if (child)
+                        q.push(child);
+                }
+            }
+            return true;
+        }
+
+        // Lazy traversal as a C++20 generator: yields references to the values in the
+        // given order. Unlike the iterators there is no state machine to write; the
+        // traversal is suspended between values, so it can be paused, zipped with another
+        // one or resumed later. The coroutine frame is recycled through FrameCache, so
+        // only the first traversal on a thread allocates one. The tree must outlive the
+        // generator and must not change while it is in use.
+        Generator<T> traverse(TraversalOrder order = TraversalOrder::PreOrder)
+        {
+            bool linear = frozen && frozenLayout == FreezeLayout::BreadthFirst;
+            NodeT *first = linear ? frozenNodes.data() : nullptr;
+            NodeT *last = linear ? frozenNodes.data() + frozenNodes.size() : nullptr;
+            return generate<T>(order, root, isBinary, first, last, resource);
+        }
+
+        Generator<const T> traverse(TraversalOrder order = TraversalOrder::PreOrder) const
+        {
+            bool linear = frozen && frozenLayout == FreezeLayout::BreadthFirst;
+            const NodeT *first = linear ? frozenNodes.data() : nullptr;
+            const NodeT *last = linear ? frozenNodes.data() + frozenNodes.size() : nullptr;
+            return generate<const T>(order, static_cast<const NodeT *>(root), isBinary, first, last, resource);
+        }
+
+        // Calls visit(value) for every node, from the threads of a work-stealing pool.
+        // The calling thread starts at the root and, like every task, hands part of its
+        // subtree to the pool each `grain` nodes; idle workers steal those parts. The
+        // order of the calls is unspecified and calls on different nodes run
+        // concurrently, so visit must be safe to call from several threads. Returns
+        // when every node was visited; an exception thrown by visit is rethrown here
+        // (the walk may then have visited only part of the tree). The tasks allocate
+        // their stacks from the tree's memory resource at the same time, so it must be
+        // thread-safe (the default resource is).
+        template <typename F>
+        void parallel_for_each(F &&visit, size_t grain = PARALLEL_GRAIN, ThreadPool &pool = ThreadPool::shared())
+        {
+            if (grain == 0)
+                throw std::invalid_argument("Grain size must be positive.");
+            if (!root)
+                return;
+
+            ThreadPool::TaskGroup group;
+            try
+            {
+                parallel_walk(root, visit, grain, pool, group, resource);
+            }
+            catch (...)
             {
-                smallest = node->children[0];
+                // Let the tasks already started finish before reporting the error
+                try
+                {
+                    pool.wait(group);
+                }
+                catch (...)
+                {
+                }
+                throw;
             }
+            pool.wait(group);
+        }
+
+        // Level-synchronous BFS for wide trees. Each level (the frontier) is cut into
+        // chunks of `grain` nodes that the pool processes in parallel (see
+        // expand_level()), building the next frontier in BFS order. Once a level is
+        // done, and before the next one starts, onLevel(depth, nodes) is called on the
+        // calling thread with the whole level in BFS order. Levels of at most `grain`
+        // nodes are processed by the calling thread alone. visit must be safe to call
+        // concurrently on different nodes; an exception from visit or onLevel stops the
+        // walk and is rethrown. The frontiers are allocated from the tree's memory
+        // resource, by the calling thread only.
+        template <typename F, typename L>
+        void parallel_bfs(F &&visit, L &&onLevel, size_t grain = PARALLEL_GRAIN, ThreadPool &pool = ThreadPool::shared())
+        {
+            if (grain == 0)
+                throw std::invalid_argument("Grain size must be positive.");
 
-            // Check right child
-            if (node->children.size() > 1 && node->children[1]->value < smallest->value)
+            NodeList frontier(resource);
+            NodeList next(resource);
+            if (root)
+                frontier.push_back(root);
+            for (size_t depth = 0; !frontier.empty(); ++depth)
             {
-                smallest = node->children[1];
+                expand_level(frontier, next, nullptr, visit, grain, pool);
+                onLevel(depth, std::span<NodeT *const>(frontier));
+                frontier.swap(next);
+            }
+        }
+
+        // Parallel bottom-up reduction. The result of a node is
+        //     combine(...combine(combine(identity, leaf(value)), r(child 0))..., r(child k-1))
+        // with the children's results r(child i) taken in child order, so combine need
+        // not be commutative. The tree is first expanded level by level (as in
+        // parallel_bfs) into one array of nodes in BFS order, then the levels are
+        // reduced from the deepest up: the nodes of a level are split into chunks of
+        // `grain` nodes that the pool evaluates in parallel, each reading its children's
+        // results from the level below. Levels of at most `grain` nodes are expanded and
+        // reduced by the calling thread without any per-level allocation, so deep and
+        // narrow trees (e.g. a chain) cost one serial pass each way. Returns the root's
+        // result (identity for an empty tree). If perNode is given, it receives every
+        // node's result in BFS order (the order of for_each_bfs), e.g. all subtree sums
+        // at once. leaf and combine must be safe to call concurrently. The scratch space
+        // is allocated from the tree's memory resource.
+        template <typename R, typename Leaf, typename Combine>
+        R reduce(const R &identity, Leaf &&leaf, Combine &&combine, std::type_identity_t<std::vector<R>> *perNode = nullptr,
+                 size_t grain = PARALLEL_GRAIN, ThreadPool &pool = ThreadPool::shared())
+        {
+            if (grain == 0)
+                throw std::invalid_argument("Grain size must be positive.");
+            if (perNode)
+                perNode->clear();
+            if (!root)
+                return identity;
+
+            // order holds every node in BFS order, levelStarts where each depth begins
+            // (plus the end), and the children of order[i] are
+            // order[firstChild[i] .. firstChild[i + 1])
+            NodeList order({root}, resource);
+            IndexList levelStarts(1, 0, resource);
+            IndexList firstChild(resource);
+            NodeList wide(resource); // Next level of a wide level, built in parallel
+            auto skip = [](const T &) {};
+            for (size_t levelBegin = 0; levelBegin < order.size();)
+            {
+                size_t levelEnd = order.size();
+                levelStarts.push_back(levelEnd);
+                firstChild.resize(levelEnd + 1);
+                if (levelEnd - levelBegin <= grain)
+                {
+                    for (size_t i = levelBegin; i < levelEnd; ++i)
+                    {
+                        firstChild[i] = order.size();
+                        for (auto child : order[i]->children)
+                        {
+                            if (child)
+                                order.push_back(child);
+                        }
+                    }
+                    firstChild[levelEnd] = order.size();
+                }
+                else
+                {
+                    std::span<NodeT *const> level(order.data() + levelBegin, levelEnd - levelBegin);
+                    expand_level(level, wide, firstChild.data() + levelBegin, skip, grain, pool);
+                    for (size_t i = levelBegin; i <= levelEnd; ++i)
+                        firstChild[i] += levelEnd;
+                    order.insert(order.end(), wide.begin(), wide.end());
+                }
+                levelBegin = levelEnd;
+            }
+
+            std::pmr::vector<R> results(order.size(), identity, resource);
+            for (size_t d = levelStarts.size() - 1; d-- > 0;)
+            {
+                size_t levelBegin = levelStarts[d];
+                auto evaluate = [&](size_t begin, size_t end)
+                {
+                    for (size_t i = levelBegin + begin; i < levelBegin + end; ++i)
+                    {
+                        R acc = combine(identity, leaf(order[i]->value));
+                        for (size_t c = firstChild[i]; c < firstChild[i + 1]; ++c)
+                            acc = combine(std::move(acc), results[c]);
+                        results[i] = std::move(acc);
+                    }
+                };
+                for_chunks(levelStarts[d + 1] - levelBegin, evaluate, grain, pool);
+            }
+
+            R total = results[0];
+            if (perNode)
+                perNode->assign(std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+            return total;
+        }
+
+        // Function to heapify a subtree rooted at node i
+        void heapify(NodeT *node)
+        {
+            NodeT *smallest = node;
+
+            // Check the left and right children, skipping empty slots
+            for (size_t c = 0; c < node->children.size() && c < 2; ++c)
+            {
+                NodeT *child = node->children[c];
+                if (child && child->value < smallest->value)
+                {
+                    smallest = child;
+                }
             }
 
             // If smallest is not the node itself, swap and heapify the affected subtree
@@ -149,46 +1214,188 @@ namespace ariel
             }
         }
 
+        // Sift a[i] down the implicit heap stored in a (children of i at 2i+1 and 2i+2)
+        static void sift_down(std::pmr::vector<T> &a, size_t i)
+        {
+            size_t n = a.size();
+            while (true)
+            {
+                size_t smallest = i;
+                size_t left = 2 * i + 1;
+                size_t right = left + 1;
+                if (left < n && a[left] < a[smallest])
+                {
+                    smallest = left;
+                }
+                if (right < n && a[right] < a[smallest])
+                {
+                    smallest = right;
+                }
+                if (smallest == i)
+                {
+                    return;
+                }
+                std::swap(a[i], a[smallest]);
+                i = smallest;
+            }
+        }
+
         // Method to convert the binary tree into a min-heap
-        HeapIterator<T> myHeap()
+        //
+        // When the tree is complete (every level full except the last, which is filled
+        // from the left) its BFS order is exactly an implicit array heap: the children
+        // of the i'th node are nodes 2i+1 and 2i+2. In that case the values are copied
+        // into one contiguous array, heapified there, and written back. Other shapes are
+        // heapified node by node through the child pointers. Either way the returned
+        // iterator walks the nodes in level order by index; it stays valid until the
+        // next call to myHeap().
+        //
+        // Heapify works bottom-up one level at a time. The nodes of a level root
+        // disjoint subtrees, so each level is split into chunks of `grain` nodes that
+        // the pool sifts down in parallel; the write-back of a complete tree's array is
+        // chunked the same way. Passes over at most `grain` nodes run on the calling
+        // thread, so a tree of at most `grain` nodes never touches the pool, and the
+        // shared pool is only started once a pass needs it (when `pool` is null). The
+        // level-order walk and the copy into the array are sequential. The result is
+        // the same as the sequential heapify. Unlike the other parallel calls, which
+        // take `ThreadPool &pool = ThreadPool::shared()`, the pool is a nullable
+        // pointer: plain myHeap() calls must not start the shared pool up front.
+        HeapIterator<T, NodeT> myHeap(size_t grain = PARALLEL_GRAIN, ThreadPool *pool = nullptr)
         {
             // Check if the tree is binary
             if (!isBinary)
             {
                 throw std::logic_error("The tree is not binary.");
             }
+            if (grain == 0)
+            {
+                throw std::invalid_argument("Grain size must be positive.");
+            }
 
+            heapOrder.clear();
+            heapValues.clear();
             if (!root)
-                return HeapIterator<T>(nullptr);
+                return HeapIterator<T, NodeT>(nullptr, resource);
 
-            // Perform heapify in reverse level order
-            std::queue<Node<T> *> q;
-            std::stack<Node<T> *> s;
-
-            q.push(root);
-            while (!q.empty())
+            // for_chunks(), taking the shared pool only for passes of more than one chunk
+            auto chunked = [&pool, grain](size_t size, auto &work)
             {
-                Node<T> *current = q.front();
-                q.pop();
-                s.push(current);
+                if (size <= grain)
+                {
+                    work(0, size);
+                    return;
+                }
+                if (!pool)
+                    pool = &ThreadPool::shared();
+                for_chunks(size, work, grain, *pool);
+            };
 
-                for (auto &child : current->children)
+            // Collect the nodes in level order, remembering where each level starts
+            bool complete = true;
+            IndexList levelStarts(resource);
+            heapOrder.push_back(root);
+            for (size_t levelBegin = 0; levelBegin < heapOrder.size();)
+            {
+                size_t levelEnd = heapOrder.size();
+                levelStarts.push_back(levelBegin);
+                for (size_t i = levelBegin; i < levelEnd; ++i)
                 {
-                    if (child)
-                        q.push(child);
+                    for (auto &child : heapOrder[i]->children)
+                    {
+                        if (child)
+                            heapOrder.push_back(child);
+                        else
+                            complete = false;
+                    }
                 }
+                levelBegin = levelEnd;
             }
 
-            // Now pop from stack and apply heapify
-            while (!s.empty())
+            size_t n = heapOrder.size();
+            levelStarts.push_back(n);
+            for (size_t i = 0; i < n && complete; ++i)
+            {
+                size_t firstChild = 2 * i + 1;
+                size_t expected = firstChild >= n ? 0 : std::min<size_t>(2, n - firstChild);
+                complete = heapOrder[i]->children.size() == expected;
+            }
+
+            if (complete)
+            {
+                heapValues.reserve(n);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    heapValues.push_back(heapOrder[i]->value);
+                }
+
+                // Only the first n / 2 indices have children
+                size_t internal = n / 2;
+                for (size_t d = levelStarts.size() - 1; d-- > 0;)
+                {
+                    size_t levelBegin = levelStarts[d];
+                    size_t levelEnd = std::min(levelStarts[d + 1], internal);
+                    if (levelBegin >= levelEnd)
+                        continue;
+                    auto sift = [this, levelBegin](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                            sift_down(heapValues, levelBegin + i);
+                    };
+                    chunked(levelEnd - levelBegin, sift);
+                }
+
+                auto store = [this](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                        heapOrder[i]->value = heapValues[i];
+                };
+                chunked(n, store);
+            }
+            else
             {
-                heapify(s.top());
-                s.pop();
+                // Perform heapify in reverse level order
+                for (size_t d = levelStarts.size() - 1; d-- > 0;)
+                {
+                    size_t levelBegin = levelStarts[d];
+                    auto sift = [this, levelBegin](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                            heapify(heapOrder[levelBegin + i]);
+                    };
+                    chunked(levelStarts[d + 1] - levelBegin, sift);
+                }
             }
 
-            return HeapIterator<T>(root);
+            return HeapIterator<T, NodeT>(heapOrder.data(), heapOrder.size(), resource);
+        }
+
+        // The implicit array heap built by the last myHeap() call (empty if the tree was
+        // not complete): element i has its children at 2i+1 and 2i+2
+        std::span<const T> heap_array() const
+        {
+            return std::span<const T>(heapValues);
         }
     };
+
+    // Tree whose nodes keep up to K child pointers inline (no per-node heap allocation)
+    template <typename T, size_t K = 2>
+    using InlineTree = Tree<T, K, Node<T, K>>;
+
+    // Tree with inline children whose nodes also link to their parents, which
+    // enables the stackless iterators (begin_*_stackless)
+    template <typename T, size_t K = 2>
+    using ParentTree = Tree<T, K, Node<T, K, true>>;
+
+    // Tree that reader threads can scan while one writer thread adds nodes
+    // (add_sub_node/emplace_child). Child lists are published atomically and old ones
+    // are reclaimed through epochs, so readers never block and never see a half-updated
+    // list. Readers hold an EpochGuard for the duration of a scan and use the usual
+    // iterators and for_each_* functions. The root must be set before readers start,
+    // and values must not change once their node is reachable. Iterators allocate
+    // from the tree's memory resource, which must therefore be thread-safe (the
+    // default resource is).
+    template <typename T, size_t K = 2>
+    using ConcurrentTree = Tree<T, K, ConcurrentNode<T>>;
 }
 
 #endif
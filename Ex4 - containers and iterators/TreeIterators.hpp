@@ -7,28 +7,133 @@
 #ifndef TREE_ITERATORS_HPP
 #define TREE_ITERATORS_HPP
 
-#include <stack>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory_resource>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include "Node.hpp"
-#include <unordered_set>
+#include "SmallStack.hpp"
 
 using namespace std;
 
 namespace ariel
 {
+    // Containers used for the iterators' traversal state. They allocate from the
+    // memory resource given to the iterator (the tree's resource for Tree::begin_*).
+    // Stacks keep ITERATOR_STACK_INLINE entries inside the iterator, so starting or
+    // copying a traversal of a shallow tree does not allocate at all.
+    const size_t ITERATOR_STACK_INLINE = 32;
+
+    template <typename U>
+    using ResourceStack = SmallStack<U, ITERATOR_STACK_INLINE>;
+
+    // Queue that also lets the iterator look ahead (see BFSIterator prefetching)
+    template <typename U>
+    class ResourceQueue : public std::queue<U, std::pmr::deque<U>>
+    {
+    public:
+        using std::queue<U, std::pmr::deque<U>>::queue;
+
+        // The i'th entry from the front
+        const U &operator[](size_t i) const
+        {
+            return this->c[i];
+        }
+    };
+
+    // Ask the CPU to start loading a node into cache (a no-op on compilers
+    // without the builtin)
+    inline void prefetch_node(const void *node)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(node);
+#else
+        (void)node;
+#endif
+    }
+
+    // Prefetching step of the BFS scan: start loading `far`, the node visited
+    // `distance` steps from now. Nodes with a heap-allocated child list need a second
+    // miss for that list, so also request the list of `near`, visited half as far ahead:
+    // its node was requested earlier and is expected to be in cache already.
+    template <typename NodeT>
+    void prefetch_ahead(NodeT *far, NodeT *near)
+    {
+        typedef typename std::remove_const<NodeT>::type MutableNode;
+
+        prefetch_node(far);
+        if constexpr (std::is_same<typename MutableNode::ChildList, std::pmr::vector<MutableNode *>>::value)
+        {
+            if (!near->children.empty())
+            {
+                prefetch_node(near->children.data());
+            }
+        }
+    }
+
+    ///// Batched traversal (mixin for every iterator): ///////
+    //
+    // next_batch fills a caller-provided buffer with the next nodes of the
+    // traversal (next_values with copies of their values) and leaves the iterator
+    // at the node after the batch. Both return how many entries were written; fewer
+    // than out.size() means the traversal has ended. Consumers can then run a
+    // vectorized kernel over each block instead of paying a call per node.
+    template <typename Derived, typename T, typename NodeT>
+    class BatchTraversal
+    {
+    public:
+        size_t next_batch(std::span<NodeT *> out)
+        {
+            Derived &self = static_cast<Derived &>(*this);
+            size_t filled = 0;
+            for (NodeT *node = self.operator->(); node && filled < out.size(); node = self.operator->())
+            {
+                out[filled++] = node;
+                ++self;
+            }
+            return filled;
+        }
+
+        size_t next_values(std::span<std::remove_cv_t<T>> out)
+        {
+            Derived &self = static_cast<Derived &>(*this);
+            size_t filled = 0;
+            for (NodeT *node = self.operator->(); node && filled < out.size(); node = self.operator->())
+            {
+                out[filled++] = node->value;
+                ++self;
+            }
+            return filled;
+        }
+    };
 
     ///// Pre-order iterator class: current, left, right ///////
 
-    template <typename T>
-    class PreOrderIterator
+    template <typename T, typename NodeT = Node<T>>
+    class PreOrderIterator : public BatchTraversal<PreOrderIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *currentNode;
-        std::stack<Node<T> *> nodeStack; // Stack to manage the traversal of nodes
-        bool isBinary;                   // Flag to determine if the tree is binary or general
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *currentNode;
+        ResourceStack<NodeT *> nodeStack; // Stack to manage the traversal of nodes
+        bool isBinary;                    // Flag to determine if the tree is binary or general
 
     public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
         // Constructor initializes the iterator at the root node
-        PreOrderIterator(Node<T> *root = nullptr, bool binary = false) : currentNode(root), isBinary(binary)
+        PreOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), currentNode(root), nodeStack(res), isBinary(binary)
         {
             if (currentNode)
             {
@@ -36,12 +141,22 @@ namespace ariel
             }
         }
 
-        T &operator*()
+        // Copies keep allocating from the same memory resource
+        PreOrderIterator(const PreOrderIterator &other)
+            : resource(other.resource), currentNode(other.currentNode), nodeStack(other.nodeStack, other.resource), isBinary(other.isBinary)
+        {
+        }
+
+        PreOrderIterator(PreOrderIterator &&other) = default;
+        PreOrderIterator &operator=(const PreOrderIterator &other) = default;
+        PreOrderIterator &operator=(PreOrderIterator &&other) = default;
+
+        T &operator*() const
         {
             return currentNode->value;
         }
 
-        Node<T> *operator->()
+        NodeT *operator->() const
         {
             return currentNode;
         }
@@ -57,11 +172,11 @@ namespace ariel
                 if (isBinary)
                 {
                     // If the tree is binary, push the right child first, then the left child
-                    if (currentNode->children.size() > 1)
+                    if (currentNode->children.size() > 1 && currentNode->children[1])
                     {
                         nodeStack.push(currentNode->children[1]);
                     }
-                    if (currentNode->children.size() > 0)
+                    if (currentNode->children.size() > 0 && currentNode->children[0])
                     {
                         nodeStack.push(currentNode->children[0]);
                     }
@@ -71,7 +186,8 @@ namespace ariel
                     // For general trees, push children in reverse order to the stack to maintain left-to-right processing
                     for (auto it = currentNode->children.rbegin(); it != currentNode->children.rend(); ++it)
                     {
-                        nodeStack.push(*it);
+                        if (*it)
+                            nodeStack.push(*it);
                     }
                 }
 
@@ -114,76 +230,54 @@ namespace ariel
     };
 
     ///// Post-order iterator class: left, right, current ///////
-    template <typename T>
-    class PostOrderIterator
+    template <typename T, typename NodeT = Node<T>>
+    class PostOrderIterator : public BatchTraversal<PostOrderIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *current;
-        std::stack<Node<T> *> stk;             // Stack to manage the traversal of nodes
-        std::unordered_set<Node<T> *> visited; // Set to track visited nodes
-        bool isBinary;                         // Flag to determine if the tree is binary or general
+        // A node on the current root-to-node path and the index of its next child to visit
+        struct Frame
+        {
+            NodeT *node;
+            size_t next;
+        };
+
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *current;
+        ResourceStack<Frame> stk; // Path from the root to the node being expanded
+        bool isBinary;            // Flag to determine if the tree is binary or general
 
-        // Helper function to push children of a node onto the stack in reverse order
-        void push_children(Node<T> *node)
+        // Number of children of node that take part in the traversal
+        size_t child_limit(NodeT *node) const
         {
-            if (node)
+            // For binary trees only the left and right children count
+            if (isBinary && node->children.size() > 2)
             {
-                stk.push(node);
-                if (isBinary)
-                {
-                    // For binary trees, push right child first, then left child
-                    if (node->children.size() > 1)
-                    {
-                        stk.push(node->children[1]); // Push right child
-                    }
-                    if (node->children.size() > 0)
-                    {
-                        stk.push(node->children[0]); // Push left child
-                    }
-                }
-                else
-                {
-                    // For general trees, push children in reverse order
-                    for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
-                    {
-                        if (*it)
-                            stk.push(*it);
-                    }
-                }
+                return 2;
             }
+            return node->children.size();
         }
 
         // Advance to the next node in the post-order traversal
         void advance()
         {
-            // Continue processing nodes while there are nodes in the stack
             while (!stk.empty())
             {
-                // Retrieve the node at the top of the stack
-                Node<T> *node = stk.top();
-
-                // Handle the null marker (indicates completion of child processing)
-                if (node == nullptr)
+                Frame &top = stk.top();
+                if (top.next < child_limit(top.node))
                 {
-                    stk.pop(); // Remove the null marker from the stack
-                    if (!stk.empty())
+                    // Descend into the next child; null children are skipped
+                    NodeT *child = top.node->children[top.next++];
+                    if (child)
                     {
-                        current = stk.top(); // Set the current node to the next node in the stack
-                        stk.pop();           // Remove that node from the stack, as it's now the current node
+                        stk.push(Frame{child, 0});
                     }
-                    return; // Exit the function since we have found the next node in the traversal
-                }
-
-                // Check if the node has been visited
-                if (visited.find(node) == visited.end())
-                {
-                    stk.push(nullptr);    // Push a null marker onto the stack to mark this node for post-visit
-                    push_children(node);  // Push the node's children onto the stack (in reverse order for correct processing)
-                    visited.insert(node); // Mark the node as visited
                 }
                 else
                 {
-                    stk.pop(); // If the node was already visited, pop it from the stack as its processing is complete
+                    // Every child is done: the node itself comes next
+                    current = top.node;
+                    stk.pop();
+                    return;
                 }
             }
 
@@ -192,22 +286,39 @@ namespace ariel
         }
 
     public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
         // Constructor initializes the iterator at the first post-order node
-        PostOrderIterator(Node<T> *root = nullptr, bool binary = false) : current(nullptr), isBinary(binary)
+        PostOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(nullptr), stk(res), isBinary(binary)
         {
             if (root)
             {
-                push_children(root);
+                stk.push(Frame{root, 0});
                 advance(); // Move to the first post-order node
             }
         }
 
+        // Copies keep allocating from the same memory resource
+        PostOrderIterator(const PostOrderIterator &other)
+            : resource(other.resource), current(other.current), stk(other.stk, other.resource), isBinary(other.isBinary)
+        {
+        }
+
+        PostOrderIterator(PostOrderIterator &&other) = default;
+        PostOrderIterator &operator=(const PostOrderIterator &other) = default;
+        PostOrderIterator &operator=(PostOrderIterator &&other) = default;
+
         T &operator*() const
         {
             return current->get_value();
         }
 
-        Node<T> *operator->() const
+        NodeT *operator->() const
         {
             return current;
         }
@@ -241,17 +352,17 @@ namespace ariel
 
     ///// In-order iterator class: left, current, right ///////
 
-    template <typename T>
-    class InOrderIterator
+    template <typename T, typename NodeT = Node<T>>
+    class InOrderIterator : public BatchTraversal<InOrderIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *current;
-        std::stack<Node<T> *> stk;             // Stack to manage nodes for traversal.
-        std::unordered_set<Node<T> *> visited; // Set to track visited nodes in DFS.
-        bool isBinary;                         // Flag to determine if the tree is binary or general.
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated.
+        NodeT *current;
+        ResourceStack<NodeT *> stk; // Stack to manage nodes for traversal.
+        bool isBinary;              // Flag to determine if the tree is binary or general.
 
         // Helper function to push all left nodes of a binary tree onto the stack.
-        void push_left(Node<T> *node)
+        void push_left(NodeT *node)
         {
             while (node)
             {
@@ -262,8 +373,15 @@ namespace ariel
         }
 
     public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
         // Constructor to initialize the iterator.
-        InOrderIterator(Node<T> *root, bool binary) : current(nullptr), isBinary(binary)
+        InOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(nullptr), stk(res), isBinary(binary)
         {
             if (isBinary)
             {
@@ -277,6 +395,16 @@ namespace ariel
             advance(); // Move to the first valid node in the iteration.
         }
 
+        // Copies keep allocating from the same memory resource.
+        InOrderIterator(const InOrderIterator &other)
+            : resource(other.resource), current(other.current), stk(other.stk, other.resource), isBinary(other.isBinary)
+        {
+        }
+
+        InOrderIterator(InOrderIterator &&other) = default;
+        InOrderIterator &operator=(const InOrderIterator &other) = default;
+        InOrderIterator &operator=(InOrderIterator &&other) = default;
+
         // Function to advance the iterator to the next node.
         void advance()
         {
@@ -301,26 +429,24 @@ namespace ariel
             }
             else
             {
-                // Handling general trees (DFS):
-                while (!stk.empty())
+                // Handling general trees (DFS). A tree has no cycles, so every node
+                // is pushed exactly once and needs no visited check.
+                if (!stk.empty())
                 {
                     current = stk.top(); // Get the top node from the stack.
                     stk.pop();           // Remove it from the stack.
 
-                    if (visited.find(current) == visited.end())
+                    // Push all children onto the stack in reverse order.
+                    for (auto it = current->children.rbegin(); it != current->children.rend(); ++it)
                     {
-                        // If the node has not been visited yet:
-                        visited.insert(current); // Mark the node as visited.
-
-                        // Push all children onto the stack in reverse order.
-                        for (auto it = current->children.rbegin(); it != current->children.rend(); ++it)
-                        {
-                            if (*it)
-                                stk.push(*it);
-                        }
-                        break; // Exit the loop once the next node has been found.
+                        if (*it)
+                            stk.push(*it);
                     }
                 }
+                else
+                {
+                    current = nullptr; // No more nodes to visit.
+                }
             }
         }
 
@@ -331,7 +457,7 @@ namespace ariel
         }
 
         // Arrow operator to access the members of the current node.
-        Node<T> *operator->() const
+        NodeT *operator->() const
         {
             return current;
         }
@@ -343,6 +469,20 @@ namespace ariel
             return *this;
         }
 
+        // Postfix increment operator: creates a copy before advancing.
+        InOrderIterator operator++(int)
+        {
+            InOrderIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        // Comparison operator to check if two iterators are at the same node.
+        bool operator==(const InOrderIterator &other) const
+        {
+            return current == other.current;
+        }
+
         // Comparison operator to check if two iterators are different.
         bool operator!=(const InOrderIterator &other) const
         {
@@ -352,15 +492,40 @@ namespace ariel
 
     ///// BFS iterator class (using queue): ///////
 
-    template <typename T>
-    class BFSIterator
+    template <typename T, typename NodeT = Node<T>>
+    class BFSIterator : public BatchTraversal<BFSIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *current;        // Current node in the BFS traversal
-        std::queue<Node<T> *> q; // Queue to manage nodes for BFS
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *current;           // Current node in the BFS traversal
+        NodeT *blockEnd;          // End of a BFS-ordered node block (linear mode), nullptr otherwise
+        ResourceQueue<NodeT *> q; // Queue to manage nodes for BFS
+        size_t prefetchDistance;  // Prefetch the node this many places ahead in the queue (0: off)
+
+        // Nodes left in the block (linear mode), capped at limit
+        size_t linear_batch_size(size_t limit) const
+        {
+            return current ? std::min<size_t>(limit, static_cast<size_t>(blockEnd - current)) : 0;
+        }
+
+        void skip_linear(size_t count)
+        {
+            if (current && (current += count) == blockEnd)
+            {
+                current = nullptr;
+            }
+        }
 
     public:
-        BFSIterator(Node<T> *root = nullptr) : current(nullptr)
+        // Forward only: queue mode forgets the nodes it passed (see FrozenBFSIterator)
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
+        BFSIterator(NodeT *root = nullptr, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(nullptr), blockEnd(nullptr), q(res), prefetchDistance(0)
         {
             if (root)
             {
@@ -369,9 +534,41 @@ namespace ariel
             }
         }
 
+        // Linear mode: [first, last) already holds the nodes in BFS order (see Tree::freeze)
+        BFSIterator(NodeT *first, NodeT *last, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(first != last ? first : nullptr), blockEnd(last), q(res), prefetchDistance(0)
+        {
+        }
+
+        // Copies keep allocating from the same memory resource
+        BFSIterator(const BFSIterator &other)
+            : resource(other.resource), current(other.current), blockEnd(other.blockEnd),
+              q(other.q, other.resource), prefetchDistance(other.prefetchDistance)
+        {
+        }
+
+        // Queue mode only: a frozen BFS block is read sequentially, which the
+        // hardware prefetcher already handles
+        void set_prefetch_distance(size_t distance)
+        {
+            prefetchDistance = distance;
+        }
+
+        BFSIterator(BFSIterator &&other) = default;
+        BFSIterator &operator=(const BFSIterator &other) = default;
+        BFSIterator &operator=(BFSIterator &&other) = default;
+
         void advance()
         {
-            if (!q.empty())
+            if (blockEnd)
+            {
+                // Linear mode: the next node in BFS order is the next node in memory
+                if (current && ++current == blockEnd)
+                {
+                    current = nullptr;
+                }
+            }
+            else if (!q.empty())
             {
                 current = q.front(); // Get the front node from the queue
                 q.pop();             // Remove it from the queue
@@ -382,6 +579,13 @@ namespace ariel
                     if (child)
                         q.push(child);
                 }
+
+                // The node `prefetchDistance` places back in the queue is visited that
+                // many steps from now: start loading it while the nodes before it are used
+                if (prefetchDistance && q.size() >= prefetchDistance)
+                {
+                    prefetch_ahead(q[prefetchDistance - 1], q[prefetchDistance / 2]);
+                }
             }
             else
             {
@@ -394,7 +598,7 @@ namespace ariel
             return current->get_value(); // Access the value of the current node
         }
 
-        Node<T> *operator->() const
+        NodeT *operator->() const
         {
             return current; // Access the members of the current node
         }
@@ -412,6 +616,38 @@ namespace ariel
             return temp;
         }
 
+        // Linear mode hands out consecutive nodes of the frozen block without walking
+        // node by node; queue mode falls back to the generic loop
+        size_t next_batch(std::span<NodeT *> out)
+        {
+            if (!blockEnd)
+            {
+                return BatchTraversal<BFSIterator, T, NodeT>::next_batch(out);
+            }
+            size_t filled = linear_batch_size(out.size());
+            for (size_t i = 0; i < filled; ++i)
+            {
+                out[i] = current + i;
+            }
+            skip_linear(filled);
+            return filled;
+        }
+
+        size_t next_values(std::span<std::remove_cv_t<T>> out)
+        {
+            if (!blockEnd)
+            {
+                return BatchTraversal<BFSIterator, T, NodeT>::next_values(out);
+            }
+            size_t filled = linear_batch_size(out.size());
+            for (size_t i = 0; i < filled; ++i)
+            {
+                out[i] = current[i].value;
+            }
+            skip_linear(filled);
+            return filled;
+        }
+
         bool operator==(const BFSIterator &other) const
         {
             return current == other.current; // Compare current nodes
@@ -423,19 +659,92 @@ namespace ariel
         }
     };
 
+    ///// BFS iterator over a frozen block (bidirectional): ///////
+
+    // Walks a block that already holds the nodes in BFS order (see Tree::freeze), so
+    // it can step backwards as well; Tree::rbegin_bfs_scan() reverses it.
+    template <typename T, typename NodeT = Node<T>>
+    class FrozenBFSIterator
+    {
+    private:
+        NodeT *current; // Current node, the block end once the scan is over
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
+        FrozenBFSIterator(NodeT *position = nullptr) : current(position) {}
+
+        T &operator*() const
+        {
+            return current->get_value();
+        }
+
+        NodeT *operator->() const
+        {
+            return current;
+        }
+
+        FrozenBFSIterator &operator++()
+        {
+            ++current;
+            return *this;
+        }
+
+        FrozenBFSIterator operator++(int)
+        {
+            FrozenBFSIterator temp = *this;
+            ++current;
+            return temp;
+        }
+
+        FrozenBFSIterator &operator--()
+        {
+            --current;
+            return *this;
+        }
+
+        FrozenBFSIterator operator--(int)
+        {
+            FrozenBFSIterator temp = *this;
+            --current;
+            return temp;
+        }
+
+        bool operator==(const FrozenBFSIterator &other) const
+        {
+            return current == other.current;
+        }
+
+        bool operator!=(const FrozenBFSIterator &other) const
+        {
+            return current != other.current;
+        }
+    };
+
     ///// DFS iterator class (using stack): ///////
 
-    template <typename T>
-    class DFSIterator
+    template <typename T, typename NodeT = Node<T>>
+    class DFSIterator : public BatchTraversal<DFSIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *current;
-        std::stack<Node<T> *> stk;             // Stack to manage nodes for DFS
-        std::unordered_set<Node<T> *> visited; // Set to track visited nodes
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *current;
+        ResourceStack<NodeT *> stk; // Stack to manage nodes for DFS
 
     public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
         // Constructor initializes the iterator
-        DFSIterator(Node<T> *root = nullptr) : current(nullptr)
+        DFSIterator(NodeT *root = nullptr, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(nullptr), stk(res)
         {
             if (root)
             {
@@ -444,29 +753,37 @@ namespace ariel
             }
         }
 
+        // Copies keep allocating from the same memory resource
+        DFSIterator(const DFSIterator &other)
+            : resource(other.resource), current(other.current), stk(other.stk, other.resource)
+        {
+        }
+
+        DFSIterator(DFSIterator &&other) = default;
+        DFSIterator &operator=(const DFSIterator &other) = default;
+        DFSIterator &operator=(DFSIterator &&other) = default;
+
         // Function to advance the iterator to the next node
         void advance()
         {
-            while (!stk.empty())
+            // A tree has no cycles, so every node is pushed exactly once and
+            // needs no visited check
+            if (!stk.empty())
             {
                 current = stk.top(); // Get the top node from the stack
                 stk.pop();           // Remove it from the stack
 
-                if (visited.find(current) == visited.end())
+                // Push all children onto the stack in reverse order
+                for (auto it = current->children.rbegin(); it != current->children.rend(); ++it)
                 {
-                    // If the node has not been visited yet
-                    visited.insert(current); // Mark the node as visited
-
-                    // Push all children onto the stack in reverse order
-                    for (auto it = current->children.rbegin(); it != current->children.rend(); ++it)
-                    {
-                        if (*it)
-                            stk.push(*it);
-                    }
-                    return; // Exit once the next node has been found
+                    if (*it)
+                        stk.push(*it);
                 }
             }
-            current = nullptr; // No more nodes to visit
+            else
+            {
+                current = nullptr; // No more nodes to visit
+            }
         }
 
         // Dereference operator to access the value of the current node
@@ -476,7 +793,7 @@ namespace ariel
         }
 
         // Arrow operator to access the members of the current node
-        Node<T> *operator->() const
+        NodeT *operator->() const
         {
             return current;
         }
@@ -509,16 +826,27 @@ namespace ariel
         }
     };
 
-    template <typename T>
-    class HeapIterator
+    template <typename T, typename NodeT = Node<T>>
+    class HeapIterator : public BatchTraversal<HeapIterator<T, NodeT>, T, NodeT>
     {
     private:
-        Node<T> *current;
-        std::queue<Node<T> *> nodeQueue; // Queue to hold nodes for level-order traversal
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *current;
+        ResourceQueue<NodeT *> nodeQueue; // Queue to hold nodes for level-order traversal
+        NodeT *const *order;              // Nodes already in level order (index mode), nullptr otherwise
+        size_t index;                     // Position of current in order
+        size_t count;                     // Number of nodes in order
 
     public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
         // Constructor initializes the iterator at the root node
-        HeapIterator(Node<T> *root = nullptr) : current(root)
+        HeapIterator(NodeT *root = nullptr, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(root), nodeQueue(res), order(nullptr), index(0), count(0)
         {
             if (current)
             {
@@ -526,14 +854,31 @@ namespace ariel
             }
         }
 
+        // Index mode: walk an array of nodes that is already in level order
+        HeapIterator(NodeT *const *levelOrder, size_t size, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : resource(res), current(size ? levelOrder[0] : nullptr), nodeQueue(res), order(levelOrder), index(0), count(size)
+        {
+        }
+
+        // Copies keep allocating from the same memory resource
+        HeapIterator(const HeapIterator &other)
+            : resource(other.resource), current(other.current), nodeQueue(other.nodeQueue, other.resource),
+              order(other.order), index(other.index), count(other.count)
+        {
+        }
+
+        HeapIterator(HeapIterator &&other) = default;
+        HeapIterator &operator=(const HeapIterator &other) = default;
+        HeapIterator &operator=(HeapIterator &&other) = default;
+
         // Dereference operator returns the current node's value
-        T &operator*()
+        T &operator*() const
         {
             return current->value;
         }
 
         // Arrow operator returns the current node
-        Node<T> *operator->()
+        NodeT *operator->() const
         {
             return current;
         }
@@ -541,6 +886,12 @@ namespace ariel
         // Prefix increment moves to the next node in level-order
         HeapIterator &operator++()
         {
+            if (order)
+            {
+                current = ++index < count ? order[index] : nullptr;
+                return *this;
+            }
+
             if (!nodeQueue.empty())
             {
                 current = nodeQueue.front();
@@ -594,6 +945,872 @@ namespace ariel
             return !(*this == other);
         }
     };
+
+    ///// Traversal ranges: ///////
+    //
+    // A begin/end iterator pair usable in range-for and with the standard
+    // algorithms, e.g. std::accumulate(tree.pre_order().begin(), ...).
+    template <typename Iterator>
+    class TraversalRange
+    {
+    private:
+        Iterator first;
+        Iterator last;
+
+    public:
+        typedef Iterator iterator;
+
+        TraversalRange(Iterator begin, Iterator end) : first(std::move(begin)), last(std::move(end)) {}
+
+        Iterator begin() const
+        {
+            return first;
+        }
+
+        Iterator end() const
+        {
+            return last;
+        }
+
+        bool empty() const
+        {
+            return first == last;
+        }
+    };
+
+    ///// Reverse iterators (using a stack): ///////
+    //
+    // The traversal orders from last node to first, for nodes without parent links.
+    // Each one walks the tree right to left: reverse pre-order is a post-order over
+    // the children taken from the last one, reverse post-order is a pre-order over
+    // them, and reverse in-order visits right, current, left. Reaching the first node
+    // costs O(depth) and each step O(1) amortized, so reading the last k values costs
+    // O(k + depth). Trees with parent links use the stackless iterators instead (see
+    // Tree::rbegin_pre_order).
+
+    // True when NodeT keeps a parent link
+    template <typename NodeT, typename = void>
+    struct has_parent_links : std::false_type
+    {
+    };
+
+    template <typename NodeT>
+    struct has_parent_links<NodeT, std::void_t<decltype(NodeT::HAS_PARENT)>> : std::bool_constant<NodeT::HAS_PARENT>
+    {
+    };
+
+    // Shared part of the reverse iterators: a stack of frames, each a node and the
+    // number of its children not visited yet (they are taken from the last one)
+    template <typename Derived, typename T, typename NodeT>
+    class ReverseIteratorBase : public BatchTraversal<Derived, T, NodeT>
+    {
+    protected:
+        struct Frame
+        {
+            NodeT *node;
+            size_t left; // Children of node still to visit: 0 .. left-1
+        };
+
+        std::pmr::memory_resource *resource; // Where the traversal state is allocated
+        NodeT *current;                      // Current node, nullptr at the end
+        ResourceStack<Frame> stk;
+        bool isBinary; // Only the left and right children take part
+
+        ReverseIteratorBase(bool binary, std::pmr::memory_resource *res)
+            : resource(res), current(nullptr), stk(res), isBinary(binary)
+        {
+        }
+
+        ReverseIteratorBase(const ReverseIteratorBase &other)
+            : resource(other.resource), current(other.current), stk(other.stk, other.resource), isBinary(other.isBinary)
+        {
+        }
+
+        ReverseIteratorBase(ReverseIteratorBase &&other) = default;
+        ReverseIteratorBase &operator=(const ReverseIteratorBase &other) = default;
+        ReverseIteratorBase &operator=(ReverseIteratorBase &&other) = default;
+
+        // Number of children of node that take part in the traversal
+        size_t child_limit(NodeT *node) const
+        {
+            size_t count = node->children.size();
+            return isBinary && count > 2 ? 2 : count;
+        }
+
+        void push(NodeT *node)
+        {
+            stk.push(Frame{node, child_limit(node)});
+        }
+
+        // Post-order over the children taken from the last one (reverse pre-order)
+        void advance_mirrored_post_order()
+        {
+            while (!stk.empty())
+            {
+                Frame &top = stk.top();
+                if (top.left > 0)
+                {
+                    NodeT *child = top.node->children[--top.left];
+                    if (child)
+                        push(child);
+                }
+                else
+                {
+                    current = top.node;
+                    stk.pop();
+                    return;
+                }
+            }
+            current = nullptr;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
+        T &operator*() const
+        {
+            return current->get_value();
+        }
+
+        NodeT *operator->() const
+        {
+            return current;
+        }
+
+        Derived operator++(int)
+        {
+            Derived temp = static_cast<Derived &>(*this);
+            ++static_cast<Derived &>(*this);
+            return temp;
+        }
+
+        bool operator==(const Derived &other) const
+        {
+            return current == other.current;
+        }
+
+        bool operator!=(const Derived &other) const
+        {
+            return current != other.current;
+        }
+    };
+
+    // Pre-order from the last node to the root
+    template <typename T, typename NodeT = Node<T>>
+    class ReversePreOrderIterator : public ReverseIteratorBase<ReversePreOrderIterator<T, NodeT>, T, NodeT>
+    {
+        typedef ReverseIteratorBase<ReversePreOrderIterator<T, NodeT>, T, NodeT> Base;
+
+    public:
+        using Base::operator++;
+
+        ReversePreOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : Base(binary, res)
+        {
+            if (root)
+            {
+                this->push(root);
+                this->advance_mirrored_post_order();
+            }
+        }
+
+        ReversePreOrderIterator &operator++()
+        {
+            this->advance_mirrored_post_order();
+            return *this;
+        }
+    };
+
+    // Post-order from the root to the first node
+    template <typename T, typename NodeT = Node<T>>
+    class ReversePostOrderIterator : public ReverseIteratorBase<ReversePostOrderIterator<T, NodeT>, T, NodeT>
+    {
+        typedef ReverseIteratorBase<ReversePostOrderIterator<T, NodeT>, T, NodeT> Base;
+
+        // Pre-order over the children taken from the last one
+        void advance()
+        {
+            if (this->stk.empty())
+            {
+                this->current = nullptr;
+                return;
+            }
+            this->current = this->stk.top().node;
+            this->stk.pop();
+            size_t limit = this->child_limit(this->current);
+            for (size_t c = 0; c < limit; ++c)
+            {
+                NodeT *child = this->current->children[c];
+                if (child)
+                    this->stk.push(typename Base::Frame{child, 0});
+            }
+        }
+
+    public:
+        using Base::operator++;
+
+        ReversePostOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : Base(binary, res)
+        {
+            if (root)
+            {
+                this->stk.push(typename Base::Frame{root, 0});
+                advance();
+            }
+        }
+
+        ReversePostOrderIterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+    };
+
+    // In-order from the last node to the first: right, current, left for binary
+    // trees; reverse pre-order for general trees (as InOrderIterator)
+    template <typename T, typename NodeT = Node<T>>
+    class ReverseInOrderIterator : public ReverseIteratorBase<ReverseInOrderIterator<T, NodeT>, T, NodeT>
+    {
+        typedef ReverseIteratorBase<ReverseInOrderIterator<T, NodeT>, T, NodeT> Base;
+
+        // Push node and its chain of right children
+        void push_right(NodeT *node)
+        {
+            while (node)
+            {
+                this->stk.push(typename Base::Frame{node, 0});
+                node = node->children.size() > 1 ? node->children[1] : nullptr;
+            }
+        }
+
+        void advance()
+        {
+            if (!this->isBinary)
+            {
+                this->advance_mirrored_post_order();
+                return;
+            }
+            if (this->stk.empty())
+            {
+                this->current = nullptr;
+                return;
+            }
+            this->current = this->stk.top().node;
+            this->stk.pop();
+            push_right(this->current->children.size() > 0 ? this->current->children[0] : nullptr);
+        }
+
+    public:
+        using Base::operator++;
+
+        ReverseInOrderIterator(NodeT *root = nullptr, bool binary = false, std::pmr::memory_resource *res = std::pmr::get_default_resource())
+            : Base(binary, res)
+        {
+            if (!root)
+                return;
+            if (binary)
+                push_right(root);
+            else
+                this->push(root);
+            advance();
+        }
+
+        ReverseInOrderIterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+    };
+
+    ///// Stackless iterators (nodes with parent links): ///////
+    //
+    // These iterators hold only the current node and the root of the scanned
+    // subtree. The next node is found from the current one by following child and
+    // parent links, so the iterators are two pointers, trivially copyable, never
+    // allocate, and can be kept as cheap bookmarks into large trees. They require
+    // a node type with parent links, e.g. Node<T, 2, true> (see ParentTree).
+
+    template <typename Derived, typename T, typename NodeT>
+    class StacklessIteratorBase : public BatchTraversal<Derived, T, NodeT>
+    {
+        static_assert(NodeT::HAS_PARENT, "Stackless iterators need nodes with parent links");
+
+    protected:
+        NodeT *current; // Current node, nullptr at the end
+        NodeT *root;    // Root of the scanned subtree; the walk never climbs above it
+
+        StacklessIteratorBase(NodeT *first, NodeT *subtreeRoot) : current(first), root(subtreeRoot) {}
+
+        // Last non-null child of node, nullptr for a leaf
+        static NodeT *last_child(NodeT *node)
+        {
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+            {
+                if (*it)
+                    return *it;
+            }
+            return nullptr;
+        }
+
+        // First non-null sibling to the left of node (node must have a parent)
+        static NodeT *prev_sibling(NodeT *node)
+        {
+            auto &siblings = node->parent->children;
+            size_t i = 0;
+            while (siblings[i] != node)
+            {
+                ++i;
+            }
+            while (i > 0)
+            {
+                if (siblings[--i])
+                    return siblings[i];
+            }
+            return nullptr;
+        }
+
+        // Last node of the pre-order of the subtree at node: follow last children down
+        static NodeT *last_in_pre_order(NodeT *node)
+        {
+            for (NodeT *child = last_child(node); child; child = last_child(node))
+            {
+                node = child;
+            }
+            return node;
+        }
+
+        // Node before node in the pre-order of the subtree at subtreeRoot, nullptr
+        // before the first one; from the end (node == nullptr) the last node
+        static NodeT *pre_order_prev(NodeT *node, NodeT *subtreeRoot)
+        {
+            if (!node)
+                return subtreeRoot ? last_in_pre_order(subtreeRoot) : nullptr;
+            if (node == subtreeRoot)
+                return nullptr;
+            NodeT *sibling = prev_sibling(node);
+            return sibling ? last_in_pre_order(sibling) : node->parent;
+        }
+
+        // First non-null child of node, nullptr for a leaf
+        static NodeT *first_child(NodeT *node)
+        {
+            for (auto child : node->children)
+            {
+                if (child)
+                    return child;
+            }
+            return nullptr;
+        }
+
+        // First non-null sibling to the right of node (node must have a parent)
+        static NodeT *next_sibling(NodeT *node)
+        {
+            auto &siblings = node->parent->children;
+            size_t i = 0;
+            while (siblings[i] != node)
+            {
+                ++i;
+            }
+            for (++i; i < siblings.size(); ++i)
+            {
+                if (siblings[i])
+                    return siblings[i];
+            }
+            return nullptr;
+        }
+
+        // Follow first children down to a leaf
+        static NodeT *first_leaf(NodeT *node)
+        {
+            for (NodeT *child = first_child(node); child; child = first_child(node))
+            {
+                node = child;
+            }
+            return node;
+        }
+
+        // Node after node in the pre-order of the subtree at subtreeRoot (nullptr at the end):
+        // its first child, or else the nearest unvisited sibling of it or of an ancestor
+        static NodeT *pre_order_next(NodeT *node, NodeT *subtreeRoot)
+        {
+            NodeT *next = first_child(node);
+            while (!next && node != subtreeRoot)
+            {
+                next = next_sibling(node);
+                node = node->parent;
+            }
+            return next;
+        }
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
+        T &operator*() const
+        {
+            return current->value;
+        }
+
+        NodeT *operator->() const
+        {
+            return current;
+        }
+
+        Derived operator++(int)
+        {
+            Derived temp = static_cast<Derived &>(*this);
+            ++static_cast<Derived &>(*this);
+            return temp;
+        }
+
+        Derived operator--(int)
+        {
+            Derived temp = static_cast<Derived &>(*this);
+            --static_cast<Derived &>(*this);
+            return temp;
+        }
+
+        bool operator==(const Derived &other) const
+        {
+            return current == other.current;
+        }
+
+        bool operator!=(const Derived &other) const
+        {
+            return current != other.current;
+        }
+    };
+
+    // Pre-order (current, children left to right) without a stack
+    template <typename T, typename NodeT>
+    class StacklessPreOrderIterator : public StacklessIteratorBase<StacklessPreOrderIterator<T, NodeT>, T, NodeT>
+    {
+        typedef StacklessIteratorBase<StacklessPreOrderIterator<T, NodeT>, T, NodeT> Base;
+
+    public:
+        using Base::operator++;
+        using Base::operator--;
+
+        StacklessPreOrderIterator(NodeT *subtreeRoot = nullptr) : Base(subtreeRoot, subtreeRoot) {}
+
+        // Iterator at position inside the subtree (nullptr for the end)
+        StacklessPreOrderIterator(NodeT *subtreeRoot, NodeT *position) : Base(position, subtreeRoot) {}
+
+        StacklessPreOrderIterator &operator++()
+        {
+            if (this->current)
+            {
+                this->current = Base::pre_order_next(this->current, this->root);
+            }
+            return *this;
+        }
+
+        // From the end: the last node, found in O(depth)
+        StacklessPreOrderIterator &operator--()
+        {
+            this->current = Base::pre_order_prev(this->current, this->root);
+            return *this;
+        }
+    };
+
+    // Post-order (children left to right, then current) without a stack
+    template <typename T, typename NodeT>
+    class StacklessPostOrderIterator : public StacklessIteratorBase<StacklessPostOrderIterator<T, NodeT>, T, NodeT>
+    {
+        typedef StacklessIteratorBase<StacklessPostOrderIterator<T, NodeT>, T, NodeT> Base;
+
+    public:
+        using Base::operator++;
+        using Base::operator--;
+
+        StacklessPostOrderIterator(NodeT *subtreeRoot = nullptr)
+            : Base(subtreeRoot ? Base::first_leaf(subtreeRoot) : nullptr, subtreeRoot)
+        {
+        }
+
+        // Iterator at position inside the subtree (nullptr for the end)
+        StacklessPostOrderIterator(NodeT *subtreeRoot, NodeT *position) : Base(position, subtreeRoot) {}
+
+        // Mirror of operator++: the last child comes before a node, and a leaf is
+        // preceded by the nearest left sibling of it or of an ancestor
+        StacklessPostOrderIterator &operator--()
+        {
+            NodeT *node = this->current;
+            if (!node)
+            {
+                this->current = this->root; // The root is last
+                return *this;
+            }
+
+            NodeT *prev = Base::last_child(node);
+            while (!prev && node != this->root)
+            {
+                prev = Base::prev_sibling(node);
+                node = node->parent;
+            }
+            this->current = prev;
+            return *this;
+        }
+
+        StacklessPostOrderIterator &operator++()
+        {
+            NodeT *node = this->current;
+            if (!node)
+                return *this;
+            if (node == this->root)
+            {
+                this->current = nullptr;
+                return *this;
+            }
+
+            // The next sibling's subtree comes first; the parent is visited after its last child
+            NodeT *sibling = Base::next_sibling(node);
+            this->current = sibling ? Base::first_leaf(sibling) : node->parent;
+            return *this;
+        }
+    };
+
+    // In-order without a stack. Binary: left subtree, current, right subtree (children[0]
+    // is the left child, children[1] the right one). General trees are scanned in
+    // pre-order, the same order InOrderIterator uses for them.
+    template <typename T, typename NodeT, bool Binary = true>
+    class StacklessInOrderIterator : public StacklessIteratorBase<StacklessInOrderIterator<T, NodeT, Binary>, T, NodeT>
+    {
+        typedef StacklessIteratorBase<StacklessInOrderIterator<T, NodeT, Binary>, T, NodeT> Base;
+
+        static NodeT *left(NodeT *node)
+        {
+            return node->children.size() > 0 ? node->children[0] : nullptr;
+        }
+
+        static NodeT *right(NodeT *node)
+        {
+            return node->children.size() > 1 ? node->children[1] : nullptr;
+        }
+
+        static NodeT *leftmost(NodeT *node)
+        {
+            while (left(node))
+            {
+                node = left(node);
+            }
+            return node;
+        }
+
+        static NodeT *rightmost(NodeT *node)
+        {
+            while (right(node))
+            {
+                node = right(node);
+            }
+            return node;
+        }
+
+        static NodeT *first(NodeT *subtreeRoot)
+        {
+            if (!subtreeRoot)
+                return nullptr;
+            return Binary ? leftmost(subtreeRoot) : subtreeRoot;
+        }
+
+    public:
+        using Base::operator++;
+        using Base::operator--;
+
+        StacklessInOrderIterator(NodeT *subtreeRoot = nullptr) : Base(first(subtreeRoot), subtreeRoot) {}
+
+        // Iterator at position inside the subtree (nullptr for the end)
+        StacklessInOrderIterator(NodeT *subtreeRoot, NodeT *position) : Base(position, subtreeRoot) {}
+
+        // Mirror of operator++ (from the end: the rightmost node)
+        StacklessInOrderIterator &operator--()
+        {
+            NodeT *node = this->current;
+            if (!Binary)
+            {
+                this->current = Base::pre_order_prev(node, this->root);
+                return *this;
+            }
+            if (!node)
+            {
+                this->current = this->root ? rightmost(this->root) : nullptr;
+                return *this;
+            }
+
+            if (left(node))
+            {
+                this->current = rightmost(left(node));
+                return *this;
+            }
+
+            // Climb until we come up from a right subtree: that parent is previous
+            while (node != this->root && right(node->parent) != node)
+            {
+                node = node->parent;
+            }
+            this->current = node != this->root ? node->parent : nullptr;
+            return *this;
+        }
+
+        StacklessInOrderIterator &operator++()
+        {
+            NodeT *node = this->current;
+            if (!node)
+                return *this;
+
+            if (!Binary)
+            {
+                this->current = Base::pre_order_next(node, this->root);
+                return *this;
+            }
+
+            if (right(node))
+            {
+                this->current = leftmost(right(node));
+                return *this;
+            }
+
+            // Climb until we come up from a left subtree: that parent is next
+            while (node != this->root && left(node->parent) != node)
+            {
+                node = node->parent;
+            }
+            this->current = node != this->root ? node->parent : nullptr;
+            return *this;
+        }
+    };
+
+    ///// Morris (threaded) iterators for binary trees: ///////
+    //
+    // In-order and pre-order scans with O(1) extra memory. Before going down a left
+    // subtree, the scan points the right slot of that subtree's last in-order node
+    // back at the current node (a "thread"), and follows the thread instead of
+    // popping a stack on the way back up. Each thread is removed the second time it
+    // is reached, so a finished scan leaves the tree exactly as it found it.
+    //
+    // While a scan is running the tree is temporarily modified: it must not be read
+    // or changed by anything else (including a second Morris scan) until the
+    // iterator reaches the end or is destroyed. The destructor runs the scan to the
+    // end to remove the remaining threads. The iterators are therefore move-only.
+    //
+    // A thread is stored in children[1] as the node pointer with its low bits set to
+    // the slot's original state, so threads never look like real children. Nodes
+    // with fewer than two children are padded while threaded; with Node<T>
+    // (std::vector children) this padding can allocate once per node, with
+    // Node<T, 2> it never does.
+    template <typename T, typename NodeT, bool PreOrder>
+    class MorrisIterator : public BatchTraversal<MorrisIterator<T, NodeT, PreOrder>, T, NodeT>
+    {
+        static_assert(alignof(NodeT) >= 4, "Threads use the two low bits of node pointers");
+
+    private:
+        // Original state of a threaded right slot, kept in the thread's low bits
+        enum : uintptr_t
+        {
+            PADDED_EMPTY = 1, // The node had no children
+            PADDED_LEFT = 2,  // The node had only a left child
+            NULL_RIGHT = 3,   // The node had a null right child
+            TAG_MASK = 3
+        };
+
+        NodeT *current; // Node the iterator points at, nullptr at the end
+        NodeT *next;    // Where the scan continues
+
+        static NodeT *left(NodeT *node)
+        {
+            return node->children.size() > 0 ? node->children[0] : nullptr;
+        }
+
+        static uintptr_t right_bits(NodeT *node)
+        {
+            return node->children.size() > 1 ? reinterpret_cast<uintptr_t>(node->children[1]) : 0;
+        }
+
+        // Right child or thread target
+        static NodeT *right(NodeT *node)
+        {
+            return reinterpret_cast<NodeT *>(right_bits(node) & ~uintptr_t(TAG_MASK));
+        }
+
+        static bool is_thread(NodeT *node)
+        {
+            return (right_bits(node) & TAG_MASK) != 0;
+        }
+
+        // Point the empty right slot of node back at target
+        static void make_thread(NodeT *node, NodeT *target)
+        {
+            uintptr_t tag;
+            if (node->children.size() == 0)
+            {
+                tag = PADDED_EMPTY;
+                node->children.push_back(nullptr);
+                node->children.push_back(nullptr);
+            }
+            else if (node->children.size() == 1)
+            {
+                tag = PADDED_LEFT;
+                node->children.push_back(nullptr);
+            }
+            else
+            {
+                tag = NULL_RIGHT;
+            }
+            node->children[1] = reinterpret_cast<NodeT *>(reinterpret_cast<uintptr_t>(target) | tag);
+        }
+
+        // Put the right slot of node back the way it was before make_thread
+        static void remove_thread(NodeT *node)
+        {
+            uintptr_t tag = right_bits(node) & TAG_MASK;
+            node->children[1] = nullptr;
+            if (tag == PADDED_EMPTY)
+            {
+                node->children.pop_back();
+                node->children.pop_back();
+            }
+            else if (tag == PADDED_LEFT)
+            {
+                node->children.pop_back();
+            }
+        }
+
+        void advance()
+        {
+            while (next)
+            {
+                NodeT *node = next;
+                NodeT *leftChild = left(node);
+                if (!leftChild)
+                {
+                    current = node;
+                    next = right(node);
+                    return;
+                }
+
+                // Last in-order node of the left subtree: either unthreaded (first visit,
+                // go left) or threaded back to node (the left subtree is done)
+                NodeT *pred = leftChild;
+                while (right(pred) && right(pred) != node)
+                {
+                    pred = right(pred);
+                }
+
+                if (right(pred) == node && is_thread(pred))
+                {
+                    remove_thread(pred);
+                    next = right(node);
+                    if (!PreOrder)
+                    {
+                        current = node;
+                        return;
+                    }
+                }
+                else
+                {
+                    make_thread(pred, node);
+                    next = leftChild;
+                    if (PreOrder)
+                    {
+                        current = node;
+                        return;
+                    }
+                }
+            }
+            current = nullptr;
+        }
+
+        // Run the scan to the end, removing every thread still in the tree
+        void finish()
+        {
+            while (next)
+            {
+                advance();
+            }
+            current = nullptr;
+        }
+
+    public:
+        typedef std::input_iterator_tag iterator_category; // Move-only: one pass
+        typedef std::remove_cv_t<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef NodeT *pointer;
+        typedef T &reference;
+
+        MorrisIterator(NodeT *root = nullptr) : current(nullptr), next(root)
+        {
+            advance();
+        }
+
+        MorrisIterator(const MorrisIterator &) = delete;
+        MorrisIterator &operator=(const MorrisIterator &) = delete;
+
+        MorrisIterator(MorrisIterator &&other) noexcept : current(other.current), next(other.next)
+        {
+            other.current = nullptr;
+            other.next = nullptr;
+        }
+
+        // Finishes this iterator's scan first. Since the right-hand side is built
+        // before that, do not assign a new scan of the same tree to a running one;
+        // assign the end iterator first.
+        MorrisIterator &operator=(MorrisIterator &&other)
+        {
+            if (this != &other)
+            {
+                finish();
+                current = other.current;
+                next = other.next;
+                other.current = nullptr;
+                other.next = nullptr;
+            }
+            return *this;
+        }
+
+        ~MorrisIterator()
+        {
+            finish();
+        }
+
+        T &operator*() const
+        {
+            return current->value;
+        }
+
+        NodeT *operator->() const
+        {
+            return current;
+        }
+
+        MorrisIterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+
+        bool operator==(const MorrisIterator &other) const
+        {
+            return current == other.current;
+        }
+
+        bool operator!=(const MorrisIterator &other) const
+        {
+            return current != other.current;
+        }
+    };
+
+    template <typename T, typename NodeT = Node<T>>
+    using MorrisInOrderIterator = MorrisIterator<T, NodeT, false>;
+
+    template <typename T, typename NodeT = Node<T>>
+    using MorrisPreOrderIterator = MorrisIterator<T, NodeT, true>;
 } // namespace ariel
 
 #endif
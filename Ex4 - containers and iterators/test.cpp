@@ -6,9 +6,24 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <string>
+#include <thread>
 #include "Tree.hpp"
 #include "Node.hpp"
 #include "TreeIterators.hpp"
+#include "CompactTree.hpp"
+#include "Complex.hpp"
 
 using namespace ariel;
 
@@ -362,3 +377,2400 @@ TEST_CASE("3'son Tree Functionality")
     delete rightChild2;
     delete rightChild3;
 }
+
+TEST_CASE("Arena-backed Tree")
+{
+    /**
+     *       root = 1
+     *     /       \
+     *    2         3
+     *   /  \
+     *  4    5
+     */
+
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *n2 = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    tree.emplace_child(n2, 4);
+    tree.emplace_child(n2, 5);
+
+    SUBCASE("Nodes are owned by the tree")
+    {
+        CHECK(tree.get_root() == root);
+        CHECK(tree.owned_nodes() == 5);
+        CHECK(root->children.size() == 2);
+        CHECK(n2->children[1]->get_value() == 5);
+    }
+
+    SUBCASE("Traversals over arena nodes")
+    {
+        std::vector<int> expected = {1, 2, 4, 5, 3};
+        std::vector<int> visited;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+        {
+            visited.push_back(*it);
+        }
+        CHECK(visited == expected);
+    }
+
+    SUBCASE("Many nodes across several slabs")
+    {
+        Tree<int> big;
+        Node<int> *node = big.emplace_root(0);
+        for (int i = 1; i < 10000; ++i)
+        {
+            node = big.emplace_child(node, i);
+        }
+        int count = 0;
+        bool inOrder = true;
+        for (auto it = big.begin_bfs_scan(); it != big.end_bfs_scan(); ++it)
+        {
+            inOrder = inOrder && (*it == count);
+            ++count;
+        }
+        CHECK(inOrder);
+        CHECK(count == 10000);
+        CHECK(big.owned_nodes() == 10000);
+    }
+
+    SUBCASE("Null parent is rejected")
+    {
+        CHECK_THROWS_AS(tree.emplace_child(nullptr, 7), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Inline children storage")
+{
+    /**
+     *       root = 10.5
+     *     /       \
+     *    20.3     30.2
+     *   /  \      /  \
+     *  15.4 5.1  25.6 35.7
+     */
+
+    InlineTree<double> tree;
+    Node<double, 2> *root = tree.emplace_root(10.5);
+    Node<double, 2> *n1 = tree.emplace_child(root, 20.3);
+    Node<double, 2> *n2 = tree.emplace_child(root, 30.2);
+    tree.emplace_child(n1, 15.4);
+    tree.emplace_child(n1, 5.1);
+    tree.emplace_child(n2, 25.6);
+    tree.emplace_child(n2, 35.7);
+
+    SUBCASE("Children live inside the node")
+    {
+        CHECK(sizeof(Node<double, 2>) <= 32);
+        CHECK(root->children.size() == 2);
+        CHECK(root->children[0] == n1);
+        CHECK_THROWS_AS(tree.emplace_child(root, 1.0), std::overflow_error);
+    }
+
+    SUBCASE("Pre-Order Traversal")
+    {
+        std::vector<double> expected = {10.5, 20.3, 15.4, 5.1, 30.2, 25.6, 35.7};
+        auto it = tree.begin_pre_order();
+        for (double value : expected)
+        {
+            CHECK(*it == value);
+            ++it;
+        }
+        CHECK(it == tree.end_pre_order());
+    }
+
+    SUBCASE("In-Order Traversal")
+    {
+        std::vector<double> expected = {15.4, 20.3, 5.1, 10.5, 25.6, 30.2, 35.7};
+        auto it = tree.begin_in_order();
+        for (double value : expected)
+        {
+            CHECK(*it == value);
+            ++it;
+        }
+    }
+
+    SUBCASE("Post-Order Traversal")
+    {
+        std::vector<double> expected = {15.4, 5.1, 20.3, 25.6, 35.7, 30.2, 10.5};
+        auto it = tree.begin_post_order();
+        for (double value : expected)
+        {
+            CHECK(*it == value);
+            ++it;
+        }
+    }
+
+    SUBCASE("BFS and DFS Traversal")
+    {
+        std::vector<double> bfs = {10.5, 20.3, 30.2, 15.4, 5.1, 25.6, 35.7};
+        auto it = tree.begin_bfs_scan();
+        for (double value : bfs)
+        {
+            CHECK(*it == value);
+            ++it;
+        }
+
+        std::vector<double> dfs = {10.5, 20.3, 15.4, 5.1, 30.2, 25.6, 35.7};
+        auto dit = tree.begin_dfs_scan();
+        for (double value : dfs)
+        {
+            CHECK(*dit == value);
+            ++dit;
+        }
+    }
+
+    SUBCASE("Heap Conversion")
+    {
+        auto heapIt = tree.myHeap();
+        std::vector<double> expectedHeap = {5.1, 10.5, 25.6, 15.4, 20.3, 30.2, 35.7};
+        for (double value : expectedHeap)
+        {
+            CHECK(*heapIt == value);
+            ++heapIt;
+        }
+    }
+
+    SUBCASE("3-ary inline tree")
+    {
+        InlineTree<int, 3> ternary;
+        Node<int, 3> *r = ternary.emplace_root(1);
+        ternary.emplace_child(r, 2);
+        ternary.emplace_child(r, 3);
+        ternary.emplace_child(r, 4);
+        CHECK_THROWS_AS(ternary.emplace_child(r, 5), std::overflow_error);
+
+        std::vector<int> expected = {1, 2, 3, 4};
+        auto it = ternary.begin_bfs_scan();
+        for (int value : expected)
+        {
+            CHECK(*it == value);
+            ++it;
+        }
+    }
+}
+
+TEST_CASE("CompactTree with index links")
+{
+    /**
+     *       root = 10.5
+     *     /       \
+     *    20.3     30.2
+     *   /  \      /  \
+     *  15.4 5.1  25.6 35.7
+     */
+
+    CompactTree<double> tree;
+    uint32_t root = tree.add_root(10.5);
+    uint32_t n1 = tree.add_sub_node(root, 20.3);
+    uint32_t n2 = tree.add_sub_node(root, 30.2);
+    tree.add_sub_node(n1, 15.4);
+    tree.add_sub_node(n1, 5.1);
+    tree.add_sub_node(n2, 25.6);
+    tree.add_sub_node(n2, 35.7);
+
+    SUBCASE("Structure")
+    {
+        CHECK(tree.size() == 7);
+        CHECK(tree.get_root() == root);
+        CHECK(tree.child_count(root) == 2);
+        CHECK(tree.value(tree.child(n1, 1)) == 5.1);
+        CHECK_THROWS_AS(tree.add_sub_node(root, 1.0), std::overflow_error);
+        CHECK_THROWS_AS(tree.add_sub_node(100, 1.0), std::invalid_argument);
+    }
+
+    SUBCASE("Traversals")
+    {
+        std::vector<double> pre = {10.5, 20.3, 15.4, 5.1, 30.2, 25.6, 35.7};
+        std::vector<double> in = {15.4, 20.3, 5.1, 10.5, 25.6, 30.2, 35.7};
+        std::vector<double> post = {15.4, 5.1, 20.3, 25.6, 35.7, 30.2, 10.5};
+        std::vector<double> bfs = {10.5, 20.3, 30.2, 15.4, 5.1, 25.6, 35.7};
+
+        std::vector<double> visited;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == pre);
+
+        visited.clear();
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == in);
+
+        visited.clear();
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == post);
+
+        visited.clear();
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == bfs);
+
+        visited.clear();
+        for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == pre);
+    }
+
+    SUBCASE("Heap Conversion")
+    {
+        auto heapIt = tree.myHeap();
+        std::vector<double> expectedHeap = {5.1, 10.5, 25.6, 15.4, 20.3, 30.2, 35.7};
+        for (double value : expectedHeap)
+        {
+            CHECK(*heapIt == value);
+            ++heapIt;
+        }
+        CHECK(heapIt == tree.end_bfs_scan());
+    }
+
+    SUBCASE("Copy of a pointer-based tree")
+    {
+        Tree<int, 3> source;
+        Node<int> *r = source.emplace_root(1);
+        Node<int> *a = source.emplace_child(r, 2);
+        source.emplace_child(r, 3);
+        source.emplace_child(a, 4);
+
+        CompactTree<int, 3> compact(source);
+        CHECK(compact.size() == 4);
+        std::vector<int> expected = {1, 2, 4, 3};
+        std::vector<int> visited;
+        for (auto it = compact.begin_pre_order(); it != compact.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+        CHECK_THROWS_AS(compact.myHeap(), std::logic_error);
+    }
+
+    SUBCASE("Copy keeps the slot of a missing left child")
+    {
+        /**
+         *       root = 3
+         *      /        \
+         *  (null)        6
+         *               / \
+         *              4   (null)
+         */
+        Tree<int> source;
+        Node<int> *r = source.emplace_root(3);
+        source.add_sub_node(r, nullptr);
+        Node<int> *right = source.emplace_child(r, 6);
+        source.emplace_child(right, 4);
+        source.add_sub_node(right, nullptr);
+
+        std::vector<int> expected;
+        for (auto it = source.begin_in_order(); it != source.end_in_order(); ++it)
+            expected.push_back(*it);
+        CHECK(expected == std::vector<int>{3, 4, 6});
+
+        CompactTree<int> compact(source);
+        CHECK(compact.size() == 3);
+        CHECK(compact.child_count(compact.get_root()) == 2);
+        CHECK(compact.child(compact.get_root(), 0) == CompactTree<int>::npos);
+        CHECK(compact.child_count(compact.child(compact.get_root(), 1)) == 1);
+
+        std::vector<int> visited;
+        for (auto it = compact.begin_in_order(); it != compact.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+
+        CompactTree<int, 2, StructOfArrays> soa(source);
+        visited.clear();
+        for (auto it = soa.begin_in_order(); it != soa.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+
+        CompactTree<int, 2, HotColdSplit> split(source);
+        visited.clear();
+        for (auto it = split.begin_in_order(); it != split.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+
+        visited.clear();
+        for (auto it = compact.begin_pre_order(); it != compact.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == std::vector<int>{3, 6, 4});
+        visited.clear();
+        for (auto it = compact.begin_post_order(); it != compact.end_post_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == std::vector<int>{4, 6, 3});
+        visited.clear();
+        for (auto it = compact.begin_bfs_scan(); it != compact.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == std::vector<int>{3, 6, 4});
+
+        visited.clear();
+        for (auto it = compact.myHeap(); it != compact.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == std::vector<int>{3, 4, 6});
+    }
+}
+
+TEST_CASE("CompactTree with StructOfArrays layout")
+{
+    Tree<double> source;
+    Node<double> *root = source.emplace_root(10.5);
+    Node<double> *n1 = source.emplace_child(root, 20.3);
+    Node<double> *n2 = source.emplace_child(root, 30.2);
+    source.emplace_child(n1, 15.4);
+    source.emplace_child(n1, 5.1);
+    source.emplace_child(n2, 25.6);
+    source.emplace_child(n2, 35.7);
+
+    CompactTree<double, 2, StructOfArrays> tree(source);
+
+    SUBCASE("Values are one dense array in BFS order")
+    {
+        std::span<double> values = tree.values();
+        std::vector<double> bfs = {10.5, 20.3, 30.2, 15.4, 5.1, 25.6, 35.7};
+        CHECK(std::vector<double>(values.begin(), values.end()) == bfs);
+        CHECK(std::accumulate(values.begin(), values.end(), 0.0) == doctest::Approx(142.8));
+        CHECK(*std::min_element(values.begin(), values.end()) == 5.1);
+    }
+
+    SUBCASE("Traversals match the pointer-based tree")
+    {
+        std::vector<double> expected;
+        for (auto it = source.begin_in_order(); it != source.end_in_order(); ++it)
+            expected.push_back(*it);
+        std::vector<double> visited;
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+
+        expected.clear();
+        for (auto it = source.begin_post_order(); it != source.end_post_order(); ++it)
+            expected.push_back(*it);
+        visited.clear();
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+    }
+
+    SUBCASE("Heap Conversion")
+    {
+        auto heapIt = tree.myHeap();
+        std::vector<double> expectedHeap = {5.1, 10.5, 25.6, 15.4, 20.3, 30.2, 35.7};
+        for (double value : expectedHeap)
+        {
+            CHECK(*heapIt == value);
+            ++heapIt;
+        }
+        CHECK(tree.values()[0] == 5.1);
+    }
+}
+
+TEST_CASE("Frozen Tree")
+{
+    /**
+     *       root = 1
+     *     /    |    \
+     *    2     3     4
+     *   / \          |
+     *  5   6         7
+     */
+
+    Tree<int, 3> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *n2 = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    Node<int> *n4 = tree.emplace_child(root, 4);
+    tree.emplace_child(n2, 5);
+    tree.emplace_child(n2, 6);
+    tree.emplace_child(n4, 7);
+
+    std::vector<int> pre = {1, 2, 5, 6, 3, 4, 7};
+    std::vector<int> post = {5, 6, 2, 3, 7, 4, 1};
+    std::vector<int> bfs = {1, 2, 3, 4, 5, 6, 7};
+
+    tree.freeze();
+
+    SUBCASE("Nodes are copied into one BFS-ordered block")
+    {
+        CHECK(tree.is_frozen());
+        Node<int> *frozenRoot = tree.get_root();
+        CHECK(frozenRoot != root);
+        for (int i = 0; i < 7; ++i)
+        {
+            CHECK(frozenRoot[i].get_value() == bfs[i]);
+        }
+        // Children of a node are a contiguous range of the block
+        CHECK(frozenRoot->children[0] == frozenRoot + 1);
+        CHECK(frozenRoot->children[2] == frozenRoot + 3);
+        CHECK(frozenRoot[1].children[0] == frozenRoot + 4);
+        CHECK(frozenRoot[3].children[0] == frozenRoot + 6);
+    }
+
+    SUBCASE("Traversals over the frozen block")
+    {
+        std::vector<int> visited;
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == bfs);
+
+        visited.clear();
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == pre);
+
+        visited.clear();
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == post);
+
+        visited.clear();
+        for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == pre);
+    }
+
+    SUBCASE("Structure is read-only once frozen")
+    {
+        CHECK_THROWS_AS(tree.emplace_child(tree.get_root(), 8), std::logic_error);
+        CHECK_THROWS_AS(tree.add_root(root), std::logic_error);
+    }
+
+    SUBCASE("Freezing a binary tree keeps the heap working")
+    {
+        Tree<double> binary;
+        Node<double> *r = binary.emplace_root(10.5);
+        Node<double> *a = binary.emplace_child(r, 20.3);
+        Node<double> *b = binary.emplace_child(r, 30.2);
+        binary.emplace_child(a, 15.4);
+        binary.emplace_child(a, 5.1);
+        binary.emplace_child(b, 25.6);
+        binary.emplace_child(b, 35.7);
+        binary.freeze();
+
+        auto heapIt = binary.myHeap();
+        std::vector<double> expectedHeap = {5.1, 10.5, 25.6, 15.4, 20.3, 30.2, 35.7};
+        for (double value : expectedHeap)
+        {
+            CHECK(*heapIt == value);
+            ++heapIt;
+        }
+    }
+
+    SUBCASE("Empty tree")
+    {
+        Tree<int> empty;
+        empty.freeze();
+        CHECK(empty.begin_bfs_scan() == empty.end_bfs_scan());
+    }
+}
+
+TEST_CASE("Van Emde Boas frozen layout")
+{
+    // Complete binary tree with 15 nodes, values 1..15 in BFS order
+    InlineTree<int> tree;
+    std::vector<Node<int, 2> *> nodes;
+    nodes.push_back(tree.emplace_root(1));
+    for (int i = 1; i < 15; ++i)
+    {
+        nodes.push_back(tree.emplace_child(nodes[(i - 1) / 2], i + 1));
+    }
+
+    std::vector<int> pre, in, post;
+    for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+        pre.push_back(*it);
+    for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+        in.push_back(*it);
+    for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+        post.push_back(*it);
+
+    tree.freeze(FreezeLayout::VanEmdeBoas);
+
+    SUBCASE("Block is in recursive van Emde Boas order")
+    {
+        std::vector<int> expected = {1, 2, 3, 4, 8, 9, 5, 10, 11, 6, 12, 13, 7, 14, 15};
+        Node<int, 2> *block = tree.get_root();
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            CHECK(block[i].get_value() == expected[i]);
+        }
+    }
+
+    SUBCASE("Traversals over the frozen copy")
+    {
+        std::vector<int> visited;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == pre);
+
+        visited.clear();
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == in);
+
+        visited.clear();
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == post);
+
+        visited.clear();
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        std::vector<int> bfs = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+        CHECK(visited == bfs);
+    }
+
+    SUBCASE("Only binary trees")
+    {
+        Tree<int, 3> ternary;
+        ternary.emplace_root(1);
+        CHECK_THROWS_AS(ternary.freeze(FreezeLayout::VanEmdeBoas), std::logic_error);
+    }
+}
+
+TEST_CASE("Heap Conversion through the implicit array heap")
+{
+    SUBCASE("Complete tree uses the array heap")
+    {
+        /**
+         *        root = 9
+         *      /       \
+         *     8         7
+         *    / \       /
+         *   6   5     4
+         */
+        Tree<int> tree;
+        Node<int> *root = tree.emplace_root(9);
+        Node<int> *a = tree.emplace_child(root, 8);
+        Node<int> *b = tree.emplace_child(root, 7);
+        tree.emplace_child(a, 6);
+        tree.emplace_child(a, 5);
+        tree.emplace_child(b, 4);
+
+        std::vector<int> visited;
+        for (auto it = tree.myHeap(); it != HeapIterator<int>(nullptr); ++it)
+            visited.push_back(*it);
+
+        std::vector<int> expected = {4, 5, 7, 6, 8, 9};
+        CHECK(visited == expected);
+        std::span<const int> heap = tree.heap_array();
+        CHECK(std::vector<int>(heap.begin(), heap.end()) == expected);
+        CHECK(root->get_value() == 4);
+    }
+
+    SUBCASE("Incomplete tree is heapified through the child pointers")
+    {
+        /**
+         *     root = 5
+         *      /
+         *     4
+         *    / \
+         *   3   1
+         */
+        Tree<int> tree;
+        Node<int> *root = tree.emplace_root(5);
+        Node<int> *a = tree.emplace_child(root, 4);
+        tree.emplace_child(a, 3);
+        tree.emplace_child(a, 1);
+
+        std::vector<int> visited;
+        for (auto it = tree.myHeap(); it != HeapIterator<int>(nullptr); ++it)
+            visited.push_back(*it);
+
+        std::vector<int> expected = {1, 3, 5, 4};
+        CHECK(visited == expected);
+        CHECK(tree.heap_array().empty());
+        CHECK(a->children[0]->get_value() == 5);
+    }
+
+    SUBCASE("Missing left children are skipped")
+    {
+        /**
+         *     root = 9
+         *    /       \
+         * (null)      6
+         *           /   \
+         *       (null)   2
+         */
+        Tree<int> tree;
+        Node<int> *root = tree.emplace_root(9);
+        tree.add_sub_node(root, nullptr);
+        Node<int> *right = tree.emplace_child(root, 6);
+        tree.add_sub_node(right, nullptr);
+        Node<int> *leaf = tree.emplace_child(right, 2);
+
+        std::vector<int> visited;
+        for (auto it = tree.myHeap(); it != HeapIterator<int>(nullptr); ++it)
+            visited.push_back(*it);
+
+        CHECK(visited == std::vector<int>{2, 6, 9});
+        CHECK(tree.heap_array().empty());
+        CHECK(root->children[0] == nullptr);
+        CHECK(leaf->get_value() == 9);
+    }
+
+    SUBCASE("Parallel heapify by level gives the sequential result")
+    {
+        // Complete tree of 5000 nodes, the same tree with one leaf cut off the middle
+        // of the last level, and with an empty left slot there instead (both
+        // heapified through the child pointers)
+        std::mt19937 rng(21);
+        std::vector<int> values(5000);
+        for (int &value : values)
+            value = static_cast<int>(rng() % 1000);
+
+        enum Shape { Complete, CutLeaf, MissingLeft };
+        auto build = [&values](Tree<int> &tree, Shape shape)
+        {
+            std::vector<Node<int> *> nodes{tree.emplace_root(values[0])};
+            for (size_t i = 1; i < values.size(); ++i)
+            {
+                Node<int> *parent = nodes[(i - 1) / 2];
+                if (shape == CutLeaf && i == 4000)
+                    nodes.push_back(nullptr);
+                else if (shape == MissingLeft && i == 3999)
+                {
+                    tree.add_sub_node(parent, nullptr);
+                    nodes.push_back(nullptr);
+                }
+                else
+                    nodes.push_back(tree.emplace_child(parent, values[i]));
+            }
+        };
+        auto heapOrder = [](Tree<int> &tree, size_t grain, ThreadPool *pool)
+        {
+            std::vector<int> order;
+            auto it = tree.myHeap(grain, pool);
+            for (; it != HeapIterator<int>(nullptr); ++it)
+                order.push_back(*it);
+            return order;
+        };
+
+        ThreadPool sequential(1);
+        for (Shape shape : {Complete, CutLeaf, MissingLeft})
+        {
+            Tree<int> reference;
+            build(reference, shape);
+            std::vector<int> expected = heapOrder(reference, 1000000, &sequential);
+            CHECK(reference.heap_array().empty() == (shape != Complete));
+            if (shape == Complete)
+                CHECK(std::is_heap(expected.begin(), expected.end(), std::greater<int>()));
+            CHECK(expected.size() == values.size() - (shape != Complete));
+
+            for (size_t threads : {2, 4})
+            {
+                ThreadPool pool(threads);
+                for (size_t grain : {size_t(1), size_t(16), size_t(300)})
+                {
+                    Tree<int> tree;
+                    build(tree, shape);
+                    CHECK(heapOrder(tree, grain, &pool) == expected);
+                }
+            }
+
+            // Without a pool, passes of more than `grain` nodes use the shared one
+            Tree<int> shared;
+            build(shared, shape);
+            CHECK(heapOrder(shared, 16, nullptr) == expected);
+        }
+
+        Tree<int> tree;
+        build(tree, Complete);
+        CHECK_THROWS_AS(tree.myHeap(0, &sequential), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Tree allocating from a memory resource")
+{
+    // Any allocation that bypasses the tree's resource hits the null resource and throws
+    std::pmr::monotonic_buffer_resource buffer(1 << 16);
+    std::pmr::memory_resource *previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+    Tree<int, 3> tree(&buffer);
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *a = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    tree.emplace_child(a, 4);
+    tree.emplace_child(a, 5);
+
+    std::vector<int> pre, post, bfs, dfs;
+    CHECK_NOTHROW(
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); it++)
+            pre.push_back(*it);
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); it++)
+            post.push_back(*it);
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); it++)
+            bfs.push_back(*it);
+        for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); it++)
+            dfs.push_back(*it);
+        tree.freeze();
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            (void)*it;
+    );
+
+    Tree<int> binary(&buffer);
+    Node<int> *r = binary.emplace_root(3);
+    binary.emplace_child(r, 2);
+    binary.emplace_child(r, 1);
+    std::vector<int> heap;
+    CHECK_NOTHROW(
+        auto heapEnd = binary.myHeap();
+        for (size_t i = 0; i < 3; ++i, ++heapEnd)
+            heap.push_back(*heapEnd);
+    );
+
+    std::pmr::set_default_resource(previous);
+
+    CHECK(pre == std::vector<int>{1, 2, 4, 5, 3});
+    CHECK(post == std::vector<int>{4, 5, 2, 3, 1});
+    CHECK(bfs == std::vector<int>{1, 2, 3, 4, 5});
+    CHECK(dfs == pre);
+    CHECK(heap == std::vector<int>{1, 2, 3});
+    CHECK(tree.get_resource() == &buffer);
+}
+
+TEST_CASE("Owning Tree: moves, clone and teardown")
+{
+    /**
+     *       root = 1
+     *     /       \
+     *    2         3
+     *   /
+     *  4
+     */
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *n2 = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    tree.emplace_child(n2, 4);
+    std::vector<int> expected = {1, 2, 4, 3};
+
+    SUBCASE("Move construction takes the nodes")
+    {
+        Tree<int> moved(std::move(tree));
+        CHECK(moved.get_root() == root);
+        CHECK(moved.owned_nodes() == 4);
+        CHECK(tree.get_root() == nullptr);
+        CHECK(tree.owned_nodes() == 0);
+        CHECK(tree.begin_pre_order() == tree.end_pre_order());
+
+        std::vector<int> visited;
+        for (auto it = moved.begin_pre_order(); it != moved.end_pre_order(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == expected);
+    }
+
+    SUBCASE("Move assignment releases the old nodes")
+    {
+        std::pmr::monotonic_buffer_resource buffer;
+        Tree<int> other(&buffer);
+        other.emplace_root(9);
+        other = std::move(tree);
+        CHECK(other.get_root() == root);
+        CHECK(other.get_resource() == std::pmr::get_default_resource());
+        CHECK(other.owned_nodes() == 4);
+    }
+
+    SUBCASE("Moving a frozen tree keeps the frozen block")
+    {
+        tree.freeze();
+        Node<int> *frozenRoot = tree.get_root();
+        Tree<int> moved(std::move(tree));
+        CHECK(moved.is_frozen());
+        CHECK(moved.get_root() == frozenRoot);
+        std::vector<int> visited;
+        for (auto it = moved.begin_bfs_scan(); it != moved.end_bfs_scan(); ++it)
+            visited.push_back(*it);
+        CHECK(visited == std::vector<int>{1, 2, 3, 4});
+    }
+
+    SUBCASE("Clone is a deep copy")
+    {
+        Tree<int> copy = tree.clone();
+        CHECK(copy.get_root() != root);
+        CHECK(copy.owned_nodes() == 4);
+
+        std::vector<int> visited;
+        for (auto it = copy.begin_pre_order(); it != copy.end_pre_order(); ++it)
+        {
+            visited.push_back(*it);
+            *it *= 10;
+        }
+        CHECK(visited == expected);
+        CHECK(root->get_value() == 1);
+        CHECK(copy.get_root()->get_value() == 10);
+    }
+
+    SUBCASE("Deep chains are copied and destroyed without recursion")
+    {
+        Tree<int> chain;
+        Node<int> *node = chain.emplace_root(0);
+        for (int i = 1; i < 1000000; ++i)
+        {
+            node = chain.emplace_child(node, i);
+        }
+        Tree<int> copy = chain.clone();
+        CHECK(copy.owned_nodes() == 1000000);
+        chain.clear();
+        CHECK(chain.get_root() == nullptr);
+        CHECK(chain.owned_nodes() == 0);
+    }
+}
+
+TEST_CASE("CompactTree with HotColdSplit layout")
+{
+    struct Payload
+    {
+        Complex number;
+        double history[12];
+    };
+
+    Tree<Payload, 3> source;
+    Node<Payload> *root = source.emplace_root(Payload{Complex(1, 1), {}});
+    Node<Payload> *a = source.emplace_child(root, Payload{Complex(2, 2), {}});
+    source.emplace_child(root, Payload{Complex(3, 3), {}});
+    source.emplace_child(a, Payload{Complex(4, 4), {}});
+
+    CompactTree<Payload, 3, HotColdSplit> tree(source);
+
+    SUBCASE("Values live in the cold array")
+    {
+        CHECK(tree.size() == 4);
+        CHECK(tree.child_count(tree.get_root()) == 2);
+        CHECK(tree.values().size() == 4);
+        CHECK(tree.values()[3].number.getReal() == 4);
+
+        CompactTree<int, 2, HotColdSplit> binary;
+        uint32_t r = binary.add_root(1);
+        binary.add_sub_node(r, 2);
+        CHECK(binary.value(binary.child(r, 0)) == 2);
+    }
+
+    SUBCASE("Traversals")
+    {
+        std::vector<double> visited;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            visited.push_back(it->number.getReal());
+        CHECK(visited == std::vector<double>{1, 2, 4, 3});
+
+        visited.clear();
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            visited.push_back(it->number.getReal());
+        CHECK(visited == std::vector<double>{4, 2, 3, 1});
+    }
+}
+
+TEST_CASE("Iterators with inline traversal stacks")
+{
+    // Counts what is taken from the heap so the spill path can be checked too
+    struct CountingResource : std::pmr::memory_resource
+    {
+        size_t allocations = 0;
+        size_t outstanding = 0;
+
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            outstanding += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            outstanding -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *a = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    tree.emplace_child(a, 4);
+    tree.emplace_child(a, 5);
+
+    SUBCASE("Starting, copying and running a shallow scan does not allocate")
+    {
+        std::pmr::memory_resource *none = std::pmr::null_memory_resource();
+        std::vector<int> pre, in;
+        CHECK_NOTHROW(
+            PreOrderIterator<int> end(nullptr, true, none);
+            for (PreOrderIterator<int> it(root, true, none); it != end;)
+            {
+                PreOrderIterator<int> copy = it++;
+                pre.push_back(*copy);
+            }
+            InOrderIterator<int> inEnd(nullptr, true, none);
+            for (InOrderIterator<int> it(root, true, none); it != inEnd; ++it)
+            {
+                InOrderIterator<int> copy = it;
+                in.push_back(*copy);
+            }
+            PostOrderIterator<int> post(nullptr, true, none);
+            DFSIterator<int> dfs(nullptr, none);
+            PostOrderIterator<int> postCopy = post;
+            DFSIterator<int> dfsCopy = dfs;
+        );
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 3});
+        CHECK(in == std::vector<int>{4, 2, 5, 1, 3});
+    }
+
+    SUBCASE("Post-order, DFS and general in-order scans need no visited set")
+    {
+        std::pmr::memory_resource *none = std::pmr::null_memory_resource();
+        std::vector<int> post, dfs, in;
+        CHECK_NOTHROW(
+            PostOrderIterator<int> postEnd(nullptr, true, none);
+            for (PostOrderIterator<int> it(root, true, none); it != postEnd; ++it)
+                post.push_back(*it);
+            DFSIterator<int> dfsEnd(nullptr, none);
+            for (DFSIterator<int> it(root, none); it != dfsEnd; it++)
+                dfs.push_back(*it);
+            InOrderIterator<int> inEnd(nullptr, false, none);
+            for (InOrderIterator<int> it(root, false, none); it != inEnd; ++it)
+                in.push_back(*it);
+        );
+        CHECK(post == std::vector<int>{4, 5, 2, 3, 1});
+        CHECK(dfs == std::vector<int>{1, 2, 4, 5, 3});
+        CHECK(in == dfs);
+    }
+
+    SUBCASE("Deep or wide trees spill to the resource and give it all back")
+    {
+        // A root with 100 children: the pre-order stack holds all of them at once
+        Tree<int, 100> wide;
+        Node<int> *top = wide.emplace_root(0);
+        for (int i = 1; i <= 100; ++i)
+            wide.emplace_child(top, i);
+
+        // A left spine of depth 100: the in-order stack holds the whole spine
+        Tree<int> deep;
+        Node<int> *node = deep.emplace_root(0);
+        for (int i = 1; i < 100; ++i)
+            node = deep.emplace_child(node, i);
+
+        CountingResource counter;
+        std::vector<int> pre, in;
+        {
+            PreOrderIterator<int> end(nullptr, false, &counter);
+            for (PreOrderIterator<int> it(top, false, &counter); it != end; ++it)
+            {
+                PreOrderIterator<int> copy = it;
+                pre.push_back(*copy);
+            }
+            InOrderIterator<int> inEnd(nullptr, true, &counter);
+            for (InOrderIterator<int> it(deep.get_root(), true, &counter); it != inEnd; ++it)
+                in.push_back(*it);
+        }
+        CHECK(counter.allocations > 0);
+        CHECK(counter.outstanding == 0);
+
+        std::vector<int> expectedPre(101), expectedIn(100);
+        std::iota(expectedPre.begin(), expectedPre.end(), 0);
+        for (int i = 0; i < 100; ++i)
+            expectedIn[i] = 99 - i;
+        CHECK(pre == expectedPre);
+        CHECK(in == expectedIn);
+    }
+
+    SUBCASE("SmallStack keeps its items across spills, copies and moves")
+    {
+        CountingResource counter;
+        SmallStack<int, 4> stack(&counter);
+        for (int i = 0; i < 4; ++i)
+            stack.push(i);
+        CHECK_FALSE(stack.is_spilled());
+        CHECK(counter.allocations == 0);
+
+        stack.push(4);
+        CHECK(stack.is_spilled());
+        CHECK(stack.size() == 5);
+
+        SmallStack<int, 4> copy = stack;
+        SmallStack<int, 4> moved = std::move(stack);
+        CHECK(stack.empty());
+        for (int i = 4; i >= 0; --i)
+        {
+            CHECK(copy.top() == i);
+            CHECK(moved.top() == i);
+            copy.pop();
+            moved.pop();
+        }
+        CHECK(copy.empty());
+        CHECK(moved.empty());
+    }
+}
+
+TEST_CASE("Parent links and stackless iterators")
+{
+    /**
+     *          root = 1
+     *        /         \
+     *       2           3
+     *     /   \          \
+     *    4     5          (null, 6)
+     *         /
+     *        7
+     */
+    ParentTree<int> tree;
+    Node<int, 2, true> *root = tree.emplace_root(1);
+    Node<int, 2, true> *n2 = tree.emplace_child(root, 2);
+    Node<int, 2, true> *n3 = tree.emplace_child(root, 3);
+    Node<int, 2, true> *n4 = tree.emplace_child(n2, 4);
+    Node<int, 2, true> *n5 = tree.emplace_child(n2, 5);
+    Node<int, 2, true> n6(6);
+    tree.add_sub_node(n3, nullptr);
+    tree.add_sub_node(n3, &n6);
+    tree.emplace_child(n5, 7);
+
+    typedef Node<int, 2, true> ParentNode;
+
+    SUBCASE("Parent links are set when children are added")
+    {
+        CHECK(root->get_parent() == nullptr);
+        CHECK(n2->get_parent() == root);
+        CHECK(n4->get_parent() == n2);
+        CHECK(n6.get_parent() == n3);
+        CHECK(sizeof(Node<int, 2>) < sizeof(ParentNode));
+    }
+
+    SUBCASE("Stackless iterators are two trivially copyable pointers")
+    {
+        CHECK(std::is_trivially_copyable<StacklessPreOrderIterator<int, ParentNode>>::value);
+        CHECK(std::is_trivially_copyable<StacklessInOrderIterator<int, ParentNode>>::value);
+        CHECK(std::is_trivially_copyable<StacklessPostOrderIterator<int, ParentNode>>::value);
+        CHECK(sizeof(StacklessPreOrderIterator<int, ParentNode>) == 2 * sizeof(void *));
+    }
+
+    SUBCASE("Stackless orders match the stack-based iterators")
+    {
+        std::vector<int> pre, in, post;
+        for (auto it = tree.begin_pre_order_stackless(); it != tree.end_pre_order_stackless(); ++it)
+            pre.push_back(*it);
+        for (auto it = tree.begin_in_order_stackless(); it != tree.end_in_order_stackless(); it++)
+            in.push_back(*it);
+        for (auto it = tree.begin_post_order_stackless(); it != tree.end_post_order_stackless(); ++it)
+            post.push_back(*it);
+
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 7, 3, 6});
+        CHECK(in == std::vector<int>{4, 2, 7, 5, 1, 3, 6});
+        CHECK(post == std::vector<int>{4, 7, 5, 2, 6, 3, 1});
+
+        std::vector<int> stackIn, stackPost;
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            stackIn.push_back(*it);
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            stackPost.push_back(*it);
+        CHECK(in == stackIn);
+        CHECK(post == stackPost);
+    }
+
+    SUBCASE("A stackless iterator can scan a subtree and serve as a bookmark")
+    {
+        std::vector<int> sub;
+        StacklessPreOrderIterator<int, ParentNode> end;
+        for (StacklessPreOrderIterator<int, ParentNode> it(n2); it != end; ++it)
+            sub.push_back(*it);
+        CHECK(sub == std::vector<int>{2, 4, 5, 7});
+
+        sub.clear();
+        for (StacklessPostOrderIterator<int, ParentNode> it(n2); it != StacklessPostOrderIterator<int, ParentNode>(); ++it)
+            sub.push_back(*it);
+        CHECK(sub == std::vector<int>{4, 7, 5, 2});
+
+        auto it = tree.begin_pre_order_stackless();
+        ++it;
+        ++it;
+        auto bookmark = it; // At 4
+        ++it;
+        CHECK(*it == 5);
+        CHECK(*bookmark == 4);
+        CHECK(bookmark->get_parent() == n2);
+    }
+
+    SUBCASE("Frozen and cloned trees keep their parent links")
+    {
+        ParentTree<int> copy = tree.clone();
+        CHECK(copy.get_root()->children[0]->get_parent() == copy.get_root());
+
+        tree.freeze();
+        std::vector<int> pre;
+        for (auto it = tree.begin_pre_order_stackless(); it != tree.end_pre_order_stackless(); ++it)
+        {
+            if (it->get_parent())
+                CHECK(std::find(it->get_parent()->children.begin(), it->get_parent()->children.end(), it.operator->()) != it->get_parent()->children.end());
+            pre.push_back(*it);
+        }
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 7, 3, 6});
+    }
+
+    SUBCASE("General trees")
+    {
+        Tree<int, 3, Node<int, 0, true>> general;
+        Node<int, 0, true> *r = general.emplace_root(1);
+        Node<int, 0, true> *a = general.emplace_child(r, 2);
+        general.emplace_child(r, 3);
+        Node<int, 0, true> *c = general.emplace_child(r, 4);
+        general.emplace_child(a, 5);
+        general.emplace_child(c, 6);
+        general.emplace_child(c, 7);
+
+        std::vector<int> pre, in, post;
+        for (auto it = general.begin_pre_order_stackless(); it != general.end_pre_order_stackless(); ++it)
+            pre.push_back(*it);
+        for (auto it = general.begin_in_order_stackless(); it != general.end_in_order_stackless(); ++it)
+            in.push_back(*it);
+        for (auto it = general.begin_post_order_stackless(); it != general.end_post_order_stackless(); ++it)
+            post.push_back(*it);
+        CHECK(pre == std::vector<int>{1, 2, 5, 3, 4, 6, 7});
+        CHECK(in == pre);
+        CHECK(post == std::vector<int>{5, 2, 3, 6, 7, 4, 1});
+    }
+}
+
+TEST_CASE("Morris in-order and pre-order iterators")
+{
+    /**
+     *          root = 1
+     *        /         \
+     *       2           3
+     *     /   \        /  \
+     *    4     5   (null)  6
+     *         /
+     *        7
+     */
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *n2 = tree.emplace_child(root, 2);
+    Node<int> *n3 = tree.emplace_child(root, 3);
+    tree.emplace_child(n2, 4);
+    Node<int> *n5 = tree.emplace_child(n2, 5);
+    tree.add_sub_node(n3, nullptr);
+    tree.emplace_child(n3, 6);
+    tree.emplace_child(n5, 7);
+
+    // Every node's child slots, in BFS order, to check that scans restore the tree
+    auto snapshot = [](Node<int> *top)
+    {
+        std::vector<std::vector<Node<int> *>> slots;
+        std::vector<Node<int> *> queue{top};
+        for (size_t i = 0; i < queue.size(); ++i)
+        {
+            slots.emplace_back(queue[i]->children.begin(), queue[i]->children.end());
+            for (auto child : queue[i]->children)
+                if (child)
+                    queue.push_back(child);
+        }
+        return slots;
+    };
+    auto before = snapshot(root);
+
+    SUBCASE("Same orders as the stack-based iterators, tree restored afterwards")
+    {
+        std::vector<int> in, pre, stackIn, stackPre;
+        for (auto it = tree.begin_in_order_morris(); it != tree.end_in_order_morris(); ++it)
+            in.push_back(*it);
+        for (auto it = tree.begin_pre_order_morris(); it != tree.end_pre_order_morris(); ++it)
+            pre.push_back(*it);
+        for (auto it = tree.begin_in_order(); it != tree.end_in_order(); ++it)
+            stackIn.push_back(*it);
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            stackPre.push_back(*it);
+
+        CHECK(in == std::vector<int>{4, 2, 7, 5, 1, 3, 6});
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 7, 3, 6});
+        CHECK(in == stackIn);
+        CHECK(pre == stackPre);
+        CHECK(snapshot(root) == before);
+    }
+
+    SUBCASE("An abandoned scan removes its threads when destroyed")
+    {
+        {
+            auto it = tree.begin_in_order_morris();
+            ++it;
+            ++it;
+            CHECK(*it == 7);
+            auto moved = std::move(it);
+            CHECK(*moved == 7);
+        }
+        CHECK(snapshot(root) == before);
+
+        auto it = tree.begin_pre_order_morris();
+        ++it;
+        CHECK(*it == 2);
+        it = tree.end_pre_order_morris(); // Assigning finishes the running scan
+        CHECK(snapshot(root) == before);
+    }
+
+    SUBCASE("Iterators are move-only")
+    {
+        CHECK_FALSE(std::is_copy_constructible<MorrisInOrderIterator<int>>::value);
+        CHECK(std::is_move_constructible<MorrisInOrderIterator<int>>::value);
+        CHECK(sizeof(MorrisPreOrderIterator<int>) == 2 * sizeof(void *));
+    }
+
+    SUBCASE("Inline children and a deep left spine")
+    {
+        InlineTree<int> deep;
+        Node<int, 2> *node = deep.emplace_root(0);
+        for (int i = 1; i < 100000; ++i)
+            node = deep.emplace_child(node, i);
+
+        int expected = 99999;
+        bool ordered = true;
+        for (auto it = deep.begin_in_order_morris(); it != deep.end_in_order_morris(); ++it)
+            ordered = ordered && *it == expected--;
+        CHECK(ordered);
+        CHECK(expected == -1);
+        CHECK(deep.get_root()->children.size() == 1);
+        CHECK(node->children.size() == 0);
+    }
+
+    SUBCASE("General trees are rejected")
+    {
+        Tree<int, 3> general;
+        general.emplace_root(1);
+        CHECK_THROWS_AS(general.begin_in_order_morris(), std::logic_error);
+        CHECK_THROWS_AS(general.begin_pre_order_morris(), std::logic_error);
+    }
+}
+
+TEST_CASE("Bidirectional iterators and reverse scans")
+{
+    /**
+     *          root = 1
+     *        /         \
+     *       2           3
+     *     /   \        /  \
+     *    4     5   (null)  6
+     *         /
+     *        7
+     */
+    ParentTree<int> tree;
+    Node<int, 2, true> *root = tree.emplace_root(1);
+    Node<int, 2, true> *n2 = tree.emplace_child(root, 2);
+    Node<int, 2, true> *n3 = tree.emplace_child(root, 3);
+    tree.emplace_child(n2, 4);
+    Node<int, 2, true> *n5 = tree.emplace_child(n2, 5);
+    tree.add_sub_node(n3, nullptr);
+    tree.emplace_child(n3, 6);
+    tree.emplace_child(n5, 7);
+
+    SUBCASE("Reverse ranges visit the forward orders backwards")
+    {
+        std::vector<int> pre, in, post;
+        for (auto it = tree.rbegin_pre_order(); it != tree.rend_pre_order(); ++it)
+            pre.push_back(*it);
+        for (auto it = tree.rbegin_in_order(); it != tree.rend_in_order(); ++it)
+            in.push_back(*it);
+        for (auto it = tree.rbegin_post_order(); it != tree.rend_post_order(); ++it)
+            post.push_back(*it);
+
+        CHECK(pre == std::vector<int>{6, 3, 7, 5, 4, 2, 1});
+        CHECK(in == std::vector<int>{6, 3, 1, 5, 7, 2, 4});
+        CHECK(post == std::vector<int>{1, 3, 6, 2, 5, 7, 4});
+    }
+
+    SUBCASE("Tail query: the last three in-order values")
+    {
+        std::vector<int> tail;
+        auto it = tree.rbegin_in_order();
+        for (int i = 0; i < 3; ++i, ++it)
+            tail.push_back(*it);
+        CHECK(tail == std::vector<int>{6, 3, 1});
+    }
+
+    SUBCASE("Trees without parent links use stack-based reverse scans")
+    {
+        // The same shape as above in a plain Tree<int>
+        Tree<int> plain;
+        Node<int> *p1 = plain.emplace_root(1);
+        Node<int> *p2 = plain.emplace_child(p1, 2);
+        Node<int> *p3 = plain.emplace_child(p1, 3);
+        plain.emplace_child(p2, 4);
+        Node<int> *p5 = plain.emplace_child(p2, 5);
+        plain.add_sub_node(p3, nullptr);
+        plain.emplace_child(p3, 6);
+        plain.emplace_child(p5, 7);
+
+        static_assert(std::is_same<decltype(plain.rbegin_in_order()), ReverseInOrderIterator<int>>::value);
+        std::vector<int> pre, in, post;
+        for (auto it = plain.rbegin_pre_order(); it != plain.rend_pre_order(); ++it)
+            pre.push_back(*it);
+        for (auto it = plain.rbegin_in_order(); it != plain.rend_in_order(); ++it)
+            in.push_back(*it);
+        for (auto it = plain.rbegin_post_order(); it != plain.rend_post_order(); it++)
+            post.push_back(*it);
+        CHECK(pre == std::vector<int>{6, 3, 7, 5, 4, 2, 1});
+        CHECK(in == std::vector<int>{6, 3, 1, 5, 7, 2, 4});
+        CHECK(post == std::vector<int>{1, 3, 6, 2, 5, 7, 4});
+
+        std::vector<int> tail;
+        auto it = plain.rbegin_in_order();
+        for (int i = 0; i < 3; ++i, ++it)
+            tail.push_back(*it);
+        CHECK(tail == std::vector<int>{6, 3, 1});
+
+        Tree<int> empty;
+        CHECK(empty.rbegin_pre_order() == empty.rend_pre_order());
+        CHECK(empty.rbegin_in_order() == empty.rend_in_order());
+        CHECK(empty.rbegin_post_order() == empty.rend_post_order());
+    }
+
+    SUBCASE("Stack-based reverse scans match the forward scans reversed")
+    {
+        std::mt19937 rng(13);
+        auto reversed = [](auto first, auto last)
+        {
+            std::vector<int> values;
+            for (; first != last; ++first)
+                values.push_back(*first);
+            std::reverse(values.begin(), values.end());
+            return values;
+        };
+        auto collect = [](auto first, auto last)
+        {
+            std::vector<int> values;
+            for (; first != last; ++first)
+                values.push_back(*first);
+            return values;
+        };
+
+        // Random binary trees with empty slots
+        for (int round = 0; round < 20; ++round)
+        {
+            Tree<int> binary;
+            std::vector<Node<int> *> open{binary.emplace_root(0)};
+            for (int i = 1; i < 200; ++i)
+            {
+                size_t pick = rng() % open.size();
+                Node<int> *parent = open[pick];
+                if (parent->children.empty() && rng() % 4 == 0)
+                    binary.add_sub_node(parent, nullptr);
+                open.push_back(binary.emplace_child(parent, i));
+                if (parent->children.size() == 2)
+                {
+                    open[pick] = open.back();
+                    open.pop_back();
+                }
+            }
+            CHECK(collect(binary.rbegin_pre_order(), binary.rend_pre_order()) == reversed(binary.begin_pre_order(), binary.end_pre_order()));
+            CHECK(collect(binary.rbegin_in_order(), binary.rend_in_order()) == reversed(binary.begin_in_order(), binary.end_in_order()));
+            CHECK(collect(binary.rbegin_post_order(), binary.rend_post_order()) == reversed(binary.begin_post_order(), binary.end_post_order()));
+        }
+
+        // General tree
+        Tree<int, 3> general;
+        std::vector<Node<int> *> nodes{general.emplace_root(0)};
+        for (int i = 1; i < 300; ++i)
+        {
+            size_t pick = rng() % nodes.size();
+            Node<int> *parent = nodes[pick];
+            nodes.push_back(general.emplace_child(parent, i));
+            if (parent->children.size() == 3)
+            {
+                nodes[pick] = nodes.back();
+                nodes.pop_back();
+            }
+        }
+        CHECK(collect(general.rbegin_pre_order(), general.rend_pre_order()) == reversed(general.begin_pre_order(), general.end_pre_order()));
+        CHECK(collect(general.rbegin_in_order(), general.rend_in_order()) == reversed(general.begin_in_order(), general.end_in_order()));
+        CHECK(collect(general.rbegin_post_order(), general.rend_post_order()) == reversed(general.begin_post_order(), general.end_post_order()));
+    }
+
+    SUBCASE("Stepping back and forth from any position")
+    {
+        auto it = tree.begin_in_order_stackless();
+        ++it;
+        ++it;
+        CHECK(*it == 7);
+        --it;
+        CHECK(*it == 2);
+        it++;
+        it--;
+        CHECK(*it == 2);
+        --it;
+        --it;
+        CHECK(it == tree.end_in_order_stackless()); // Before the first node
+
+        auto post = tree.end_post_order_stackless();
+        --post;
+        CHECK(*post == 1);
+        --post;
+        CHECK(*post == 3);
+
+        auto pre = tree.end_pre_order_stackless();
+        pre--;
+        CHECK(*pre == 6);
+    }
+
+    SUBCASE("General trees")
+    {
+        Tree<int, 3, Node<int, 0, true>> general;
+        Node<int, 0, true> *r = general.emplace_root(1);
+        Node<int, 0, true> *a = general.emplace_child(r, 2);
+        general.emplace_child(r, 3);
+        Node<int, 0, true> *c = general.emplace_child(r, 4);
+        general.emplace_child(a, 5);
+        general.emplace_child(c, 6);
+        general.emplace_child(c, 7);
+
+        std::vector<int> pre, in, post;
+        for (auto it = general.rbegin_pre_order(); it != general.rend_pre_order(); ++it)
+            pre.push_back(*it);
+        for (auto it = general.rbegin_in_order(); it != general.rend_in_order(); ++it)
+            in.push_back(*it);
+        for (auto it = general.rbegin_post_order(); it != general.rend_post_order(); ++it)
+            post.push_back(*it);
+        CHECK(pre == std::vector<int>{7, 6, 4, 3, 5, 2, 1});
+        CHECK(in == pre);
+        CHECK(post == std::vector<int>{1, 4, 7, 6, 3, 2, 5});
+    }
+
+    SUBCASE("Reverse BFS over a frozen tree")
+    {
+        CHECK_THROWS_AS(tree.rbegin_bfs_scan(), std::logic_error);
+        static_assert(!std::bidirectional_iterator<BFSIterator<int, Node<int, 2, true>>>);
+        static_assert(std::bidirectional_iterator<FrozenBFSIterator<int, Node<int, 2, true>>>);
+
+        tree.freeze();
+        std::vector<int> bfs;
+        for (auto it = tree.rbegin_bfs_scan(); it != tree.rend_bfs_scan(); ++it)
+            bfs.push_back(*it);
+        CHECK(bfs == std::vector<int>{7, 6, 5, 4, 3, 2, 1});
+
+        auto it = tree.rend_bfs_scan().base();
+        ++it;
+        ++it;
+        --it;
+        CHECK(*it == 2);
+
+        Tree<int, 2> vebTree;
+        vebTree.emplace_root(1);
+        vebTree.freeze(FreezeLayout::VanEmdeBoas);
+        CHECK_THROWS_AS(vebTree.rbegin_bfs_scan(), std::logic_error);
+    }
+}
+
+TEST_CASE("Standard iterator traits and traversal ranges")
+{
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *a = tree.emplace_child(root, 2);
+    tree.emplace_child(root, 3);
+    tree.emplace_child(a, 4);
+    tree.emplace_child(a, 5);
+
+    SUBCASE("The iterators model the standard iterator concepts")
+    {
+        static_assert(std::forward_iterator<PreOrderIterator<int>>);
+        static_assert(std::forward_iterator<InOrderIterator<int>>);
+        static_assert(std::forward_iterator<PostOrderIterator<int>>);
+        static_assert(std::forward_iterator<BFSIterator<int>>);
+        static_assert(std::forward_iterator<DFSIterator<int>>);
+        static_assert(std::forward_iterator<HeapIterator<int>>);
+        static_assert(std::bidirectional_iterator<StacklessInOrderIterator<int, Node<int, 2, true>>>);
+        static_assert(std::forward_iterator<PreOrderIterator<const int, const Node<int>>>);
+        static_assert(std::ranges::forward_range<TraversalRange<InOrderIterator<int>>>);
+        static_assert(std::is_same<std::iterator_traits<DFSIterator<int>>::value_type, int>::value);
+        static_assert(std::is_same<std::iterator_traits<PreOrderIterator<const int, const Node<int>>>::value_type, int>::value);
+        CHECK(true);
+    }
+
+    SUBCASE("Range-for and standard algorithms")
+    {
+        std::vector<int> in;
+        for (int value : tree.in_order())
+            in.push_back(value);
+        CHECK(in == std::vector<int>{4, 2, 5, 1, 3});
+
+        auto pre = tree.pre_order();
+        CHECK(std::accumulate(pre.begin(), pre.end(), 0) == 15);
+        auto post = tree.post_order();
+        CHECK(*std::find_if(post.begin(), post.end(), [](int v) { return v > 4; }) == 5);
+        auto bfs = tree.bfs_scan();
+        CHECK(std::reduce(bfs.begin(), bfs.end()) == 15);
+        auto dfs = tree.dfs_scan();
+        CHECK(std::count_if(dfs.begin(), dfs.end(), [](int v) { return v % 2 == 0; }) == 2);
+        CHECK(std::ranges::max(tree.in_order()) == 5);
+
+        for (int &value : tree.pre_order())
+            value *= 10;
+        CHECK(root->value == 10);
+        CHECK(a->children[1]->value == 50);
+    }
+
+    SUBCASE("Const trees give read-only ranges")
+    {
+        const Tree<int> &view = tree;
+        std::vector<int> post;
+        for (const int &value : view.post_order())
+            post.push_back(value);
+        CHECK(post == std::vector<int>{4, 5, 2, 3, 1});
+
+        auto in = view.in_order();
+        static_assert(std::is_same<decltype(*in.begin()), const int &>::value);
+        CHECK(std::accumulate(in.begin(), in.end(), 0) == 15);
+
+        tree.freeze();
+        auto bfs = view.bfs_scan();
+        CHECK(std::vector<int>(bfs.begin(), bfs.end()) == std::vector<int>{1, 2, 3, 4, 5});
+        CHECK(view.dfs_scan().begin()->value == 1);
+        CHECK_FALSE(view.pre_order().empty());
+    }
+
+    SUBCASE("InOrderIterator equality and postfix increment")
+    {
+        auto it = tree.begin_in_order();
+        auto before = it++;
+        CHECK(*before == 4);
+        CHECK(*it == 2);
+        CHECK(it.operator->() == a);
+        CHECK(before == tree.begin_in_order());
+        InOrderIterator<int> end;
+        CHECK(end == tree.end_in_order());
+    }
+}
+
+TEST_CASE("Internal visitor traversals")
+{
+    /**
+     *       root = 1
+     *     /       \
+     *    2         3
+     *   / \       /
+     *  4   5     6
+     */
+    Tree<int> tree;
+    Node<int> *root = tree.emplace_root(1);
+    Node<int> *a = tree.emplace_child(root, 2);
+    Node<int> *b = tree.emplace_child(root, 3);
+    tree.emplace_child(a, 4);
+    tree.emplace_child(a, 5);
+    tree.emplace_child(b, 6);
+
+    auto collect = [](std::vector<int> &out) { return [&out](int value) { out.push_back(value); }; };
+
+    SUBCASE("Same orders as the iterators")
+    {
+        std::vector<int> pre, in, post, bfs;
+        CHECK(tree.for_each_pre_order(collect(pre)));
+        CHECK(tree.for_each_in_order(collect(in)));
+        CHECK(tree.for_each_post_order(collect(post)));
+        CHECK(tree.for_each_bfs(collect(bfs)));
+
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 3, 6});
+        CHECK(in == std::vector<int>{4, 2, 5, 1, 6, 3});
+        CHECK(post == std::vector<int>{4, 5, 2, 6, 3, 1});
+        CHECK(bfs == std::vector<int>{1, 2, 3, 4, 5, 6});
+
+        tree.freeze();
+        std::vector<int> frozenBfs;
+        CHECK(tree.for_each_bfs(collect(frozenBfs)));
+        CHECK(frozenBfs == bfs);
+    }
+
+    SUBCASE("Returning false stops the walk")
+    {
+        std::vector<int> seen;
+        bool finished = tree.for_each_in_order([&seen](int value)
+                                               {
+                                                   seen.push_back(value);
+                                                   return value != 5;
+                                               });
+        CHECK_FALSE(finished);
+        CHECK(seen == std::vector<int>{4, 2, 5});
+
+        int visits = 0;
+        CHECK_FALSE(tree.for_each_bfs([&visits](int) { return ++visits < 2; }));
+        CHECK(visits == 2);
+        CHECK(tree.for_each_post_order([](int) { return true; }));
+    }
+
+    SUBCASE("Values can be changed in place")
+    {
+        tree.for_each_pre_order([](int &value) { value *= 2; });
+        CHECK(root->value == 2);
+        CHECK(b->children[0]->value == 12);
+    }
+
+    SUBCASE("General trees")
+    {
+        Tree<int, 3> general;
+        Node<int> *r = general.emplace_root(1);
+        Node<int> *c = general.emplace_child(r, 2);
+        general.emplace_child(r, 3);
+        general.emplace_child(r, 4);
+        general.emplace_child(c, 5);
+
+        std::vector<int> pre, in, post;
+        general.for_each_pre_order(collect(pre));
+        general.for_each_in_order(collect(in));
+        general.for_each_post_order(collect(post));
+        CHECK(pre == std::vector<int>{1, 2, 5, 3, 4});
+        CHECK(in == pre);
+        CHECK(post == std::vector<int>{5, 2, 3, 4, 1});
+    }
+}
+
+TEST_CASE("Batched traversal")
+{
+    // Complete binary tree with the values 0..9 in BFS order
+    Tree<int> tree;
+    std::vector<Node<int> *> nodes{tree.emplace_root(0)};
+    for (int i = 1; i < 10; ++i)
+        nodes.push_back(tree.emplace_child(nodes[(i - 1) / 2], i));
+
+    // Drain an iterator in batches of four and check the batches agree with ++
+    auto batches = [](auto it, auto end)
+    {
+        std::vector<int> viaIncrement;
+        for (auto copy = it; copy != end; ++copy)
+            viaIncrement.push_back(*copy);
+
+        std::vector<int> viaBatches;
+        Node<int> *buffer[4];
+        size_t filled;
+        while ((filled = it.next_batch(std::span<Node<int> *>(buffer, 4))) > 0)
+        {
+            for (size_t i = 0; i < filled; ++i)
+                viaBatches.push_back(buffer[i]->value);
+            if (filled < 4)
+                CHECK(it == end);
+        }
+        CHECK(viaBatches == viaIncrement);
+        return viaBatches;
+    };
+
+    SUBCASE("Every order fills node batches")
+    {
+        CHECK(batches(tree.begin_pre_order(), tree.end_pre_order()).size() == 10);
+        CHECK(batches(tree.begin_in_order(), tree.end_in_order()).size() == 10);
+        CHECK(batches(tree.begin_post_order(), tree.end_post_order()).size() == 10);
+        CHECK(batches(tree.begin_dfs_scan(), tree.end_dfs_scan()).size() == 10);
+        std::vector<int> bfs = batches(tree.begin_bfs_scan(), tree.end_bfs_scan());
+        CHECK(bfs == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+    }
+
+    SUBCASE("Values in batches, including the frozen BFS fast path")
+    {
+        std::vector<int> values(3);
+        auto in = tree.begin_in_order();
+        CHECK(in.next_values(std::span<int>(values)) == 3);
+        CHECK(values == std::vector<int>{7, 3, 8});
+        CHECK(*in == 1);
+
+        tree.freeze();
+        auto bfs = tree.begin_bfs_scan();
+        std::vector<int> all;
+        size_t filled;
+        while ((filled = bfs.next_values(std::span<int>(values))) > 0)
+            all.insert(all.end(), values.begin(), values.begin() + filled);
+        CHECK(all == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        CHECK(bfs == tree.end_bfs_scan());
+
+        auto again = tree.begin_bfs_scan();
+        Node<int> *buffer[16];
+        CHECK(again.next_batch(std::span<Node<int> *>(buffer, 16)) == 10);
+        CHECK(buffer[9] == buffer[0] + 9); // Consecutive nodes of the frozen block
+        CHECK(again.next_batch(std::span<Node<int> *>(buffer, 16)) == 0);
+    }
+
+    SUBCASE("Stackless and Morris iterators")
+    {
+        ParentTree<int> parentTree;
+        Node<int, 2, true> *r = parentTree.emplace_root(1);
+        parentTree.emplace_child(r, 2);
+        parentTree.emplace_child(r, 3);
+        std::vector<int> values(8);
+        auto it = parentTree.begin_post_order_stackless();
+        CHECK(it.next_values(std::span<int>(values)) == 3);
+        CHECK(std::vector<int>(values.begin(), values.begin() + 3) == std::vector<int>{2, 3, 1});
+
+        auto morris = tree.begin_in_order_morris();
+        CHECK(morris.next_values(std::span<int>(values)) == 8);
+        CHECK(values[0] == 7);
+    }
+}
+
+TEST_CASE("Prefetching BFS scan")
+{
+    // Random 3-ary tree: the prefetching scan must give the plain BFS order
+    Tree<int, 3> tree;
+    std::vector<Node<int> *> nodes{tree.emplace_root(0)};
+    std::mt19937 rng(3);
+    for (int i = 1; i < 200; ++i)
+    {
+        Node<int> *parent = nodes[rng() % nodes.size()];
+        if (parent->children.size() < 3)
+            nodes.push_back(tree.emplace_child(parent, i));
+    }
+
+    std::vector<int> plain;
+    for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+        plain.push_back(*it);
+    CHECK(plain.size() == nodes.size());
+
+    for (size_t distance : {0, 1, 2, 8, 16, 1000})
+    {
+        std::vector<int> prefetched;
+        for (auto it = tree.begin_bfs_scan(distance); it != tree.end_bfs_scan(); ++it)
+            prefetched.push_back(*it);
+        CHECK(prefetched == plain);
+    }
+
+    SUBCASE("Copies keep the distance, frozen trees ignore it")
+    {
+        auto it = tree.begin_bfs_scan(4);
+        ++it;
+        auto copy = it;
+        std::vector<int> rest;
+        for (; copy != tree.end_bfs_scan(); ++copy)
+            rest.push_back(*copy);
+        CHECK(rest == std::vector<int>(plain.begin() + 1, plain.end()));
+
+        tree.freeze();
+        std::vector<int> frozen;
+        for (auto f = tree.begin_bfs_scan(8); f != tree.end_bfs_scan(); ++f)
+            frozen.push_back(*f);
+        CHECK(frozen == plain);
+    }
+}
+
+TEST_CASE("Generator traversals")
+{
+    // Complete binary tree with the values 0..9 in BFS order
+    Tree<int> tree;
+    std::vector<Node<int> *> nodes{tree.emplace_root(0)};
+    for (int i = 1; i < 10; ++i)
+        nodes.push_back(tree.emplace_child(nodes[(i - 1) / 2], i));
+
+    auto collect = [](auto &&generator)
+    {
+        std::vector<int> values;
+        for (int value : generator)
+            values.push_back(value);
+        return values;
+    };
+    auto iterate = [](auto it, auto end)
+    {
+        std::vector<int> values;
+        for (; it != end; ++it)
+            values.push_back(*it);
+        return values;
+    };
+
+    SUBCASE("Same orders as the iterators")
+    {
+        CHECK(collect(tree.traverse()) == iterate(tree.begin_pre_order(), tree.end_pre_order()));
+        CHECK(collect(tree.traverse(TraversalOrder::InOrder)) == iterate(tree.begin_in_order(), tree.end_in_order()));
+        CHECK(collect(tree.traverse(TraversalOrder::PostOrder)) == iterate(tree.begin_post_order(), tree.end_post_order()));
+        CHECK(collect(tree.traverse(TraversalOrder::BreadthFirst)) == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+
+        Tree<int, 3> ternary;
+        Node<int> *r = ternary.emplace_root(1);
+        Node<int> *a = ternary.emplace_child(r, 2);
+        ternary.emplace_child(r, 3);
+        ternary.emplace_child(r, 4);
+        ternary.emplace_child(a, 5);
+        CHECK(collect(ternary.traverse(TraversalOrder::InOrder)) == std::vector<int>{1, 2, 5, 3, 4});
+        CHECK(collect(ternary.traverse(TraversalOrder::PostOrder)) == std::vector<int>{5, 2, 3, 4, 1});
+
+        Tree<int> empty;
+        CHECK(collect(empty.traverse()).empty());
+    }
+
+    SUBCASE("Values are references, const trees yield const values")
+    {
+        for (int &value : tree.traverse(TraversalOrder::BreadthFirst))
+            value *= 10;
+        CHECK(nodes[9]->value == 90);
+
+        const Tree<int> &view = tree;
+        static_assert(std::is_same_v<decltype(*view.traverse().begin()), const int &>);
+        CHECK(collect(view.traverse(TraversalOrder::PostOrder)).front() == 70);
+
+        tree.freeze();
+        CHECK(collect(tree.traverse(TraversalOrder::BreadthFirst)) == std::vector<int>{0, 10, 20, 30, 40, 50, 60, 70, 80, 90});
+        CHECK(collect(view.traverse(TraversalOrder::InOrder)) == std::vector<int>{70, 30, 80, 10, 90, 40, 0, 50, 20, 60});
+    }
+
+    SUBCASE("Paused and interleaved scans")
+    {
+        // Zip pre-order with BFS, one step of each at a time
+        auto pre = tree.traverse();
+        auto bfs = tree.traverse(TraversalOrder::BreadthFirst);
+        auto p = pre.begin();
+        auto b = bfs.begin();
+        std::vector<std::pair<int, int>> zipped;
+        for (; p != pre.end() && b != bfs.end(); ++p, ++b)
+            zipped.emplace_back(*p, *b);
+        CHECK(zipped.size() == 10);
+        CHECK(zipped[1] == std::pair<int, int>(1, 1));
+        CHECK(zipped[2] == std::pair<int, int>(3, 2));
+
+        // Stop early: destroying the generator ends the coroutine
+        int taken = 0;
+        for (int value : tree.traverse(TraversalOrder::PostOrder))
+        {
+            (void)value;
+            if (++taken == 3)
+                break;
+        }
+        CHECK(taken == 3);
+    }
+
+    SUBCASE("Frames are recycled")
+    {
+        collect(tree.traverse(TraversalOrder::PostOrder));
+        size_t fresh = FrameCache::local().fresh_allocations();
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK(collect(tree.traverse(TraversalOrder::PostOrder)).size() == 10);
+        }
+        CHECK(FrameCache::local().fresh_allocations() == fresh);
+    }
+
+    SUBCASE("Exceptions reach the consumer")
+    {
+        auto failing = []() -> Generator<int>
+        {
+            static int value = 1;
+            co_yield value;
+            throw std::runtime_error("stop");
+        };
+        auto generator = failing();
+        auto it = generator.begin();
+        CHECK(*it == 1);
+        CHECK_THROWS_AS(++it, std::runtime_error);
+        CHECK(it == generator.end());
+    }
+}
+
+// Thread-safe resource that counts its allocations, for the parallel walks that
+// allocate from the tree's resource on several threads at once
+struct SharedCountingResource : std::pmr::memory_resource
+{
+    std::atomic<size_t> allocations{0};
+    std::pmr::synchronized_pool_resource pool;
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocations;
+        return pool.allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        pool.deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+TEST_CASE("Parallel for_each")
+{
+    // Random 3-ary tree with the values 1..n
+    const int n = 20000;
+    Tree<int, 3> tree;
+    std::vector<Node<int> *> open{tree.emplace_root(1)};
+    std::mt19937 rng(9);
+    for (int i = 2; i <= n; ++i)
+    {
+        size_t pick = rng() % open.size();
+        Node<int> *parent = open[pick];
+        open.push_back(tree.emplace_child(parent, i));
+        if (parent->children.size() == 3)
+        {
+            open[pick] = open.back();
+            open.pop_back();
+        }
+    }
+    const long expected = static_cast<long>(n) * (n + 1) / 2;
+
+    SUBCASE("Every node is visited once, for any grain and pool size")
+    {
+        for (size_t threads : {1, 2, 4})
+        {
+            ThreadPool pool(threads);
+            CHECK(pool.size() == threads);
+            for (size_t grain : {size_t(1), size_t(64), PARALLEL_GRAIN, size_t(1000000)})
+            {
+                std::atomic<long> sum(0);
+                std::atomic<int> calls(0);
+                tree.parallel_for_each([&](int value)
+                                       { sum += value; ++calls; }, grain, pool);
+                CHECK(sum == expected);
+                CHECK(calls == n);
+            }
+        }
+
+        std::atomic<long> sum(0);
+        tree.parallel_for_each([&](int value) { sum += value; });
+        CHECK(sum == expected);
+    }
+
+    SUBCASE("Values can be updated in place")
+    {
+        ThreadPool pool(3);
+        tree.parallel_for_each([](int &value) { value *= 2; }, 16, pool);
+        long sum = 0;
+        tree.for_each_pre_order([&](int value) { sum += value; });
+        CHECK(sum == 2 * expected);
+    }
+
+    SUBCASE("Nested parallel walks and exceptions")
+    {
+        ThreadPool pool(2);
+        Tree<int> small;
+        Node<int> *r = small.emplace_root(1);
+        small.emplace_child(r, 2);
+        small.emplace_child(r, 3);
+
+        // A task that waits for nested work helps run it instead of blocking
+        std::atomic<long> nested(0);
+        small.parallel_for_each([&](int)
+                                { tree.parallel_for_each([&](int value) { nested += value; }, 256, pool); }, 1, pool);
+        CHECK(nested == 3 * expected);
+
+        CHECK_THROWS_AS(tree.parallel_for_each([](int value)
+                                               { if (value == n / 2) throw std::runtime_error("stop"); }, 64, pool),
+                        std::runtime_error);
+        CHECK_THROWS_AS(tree.parallel_for_each([](int) {}, 0, pool), std::invalid_argument);
+
+        Tree<int> empty;
+        int calls = 0;
+        empty.parallel_for_each([&](int) { ++calls; }, 1, pool);
+        CHECK(calls == 0);
+    }
+
+    SUBCASE("Traversal stacks come from the tree's memory resource")
+    {
+        SharedCountingResource counter;
+        Tree<int, 3> local(&counter);
+        std::vector<Node<int> *> nodes{local.emplace_root(1)};
+        for (int i = 2; i <= 1000; ++i)
+            nodes.push_back(local.emplace_child(nodes[(i - 2) / 3], i));
+
+        ThreadPool pool(3);
+        size_t before = counter.allocations;
+        std::atomic<long> sum(0);
+        local.parallel_for_each([&](int value) { sum += value; }, 8, pool);
+        CHECK(sum == 1000L * 1001 / 2);
+        CHECK(counter.allocations > before);
+    }
+
+    SUBCASE("Thread pool tasks and groups")
+    {
+        ThreadPool pool(4);
+        ThreadPool::TaskGroup group;
+        std::atomic<int> done(0);
+        for (int i = 0; i < 100; ++i)
+            pool.run(group, [&done] { ++done; });
+        pool.wait(group);
+        CHECK(done == 100);
+
+        ThreadPool::TaskGroup failing;
+        pool.run(failing, [] { throw std::logic_error("task"); });
+        CHECK_THROWS_AS(pool.wait(failing), std::logic_error);
+    }
+
+    SUBCASE("Waiting threads sleep instead of spinning")
+    {
+        // The only task sleeps: the waiting thread finds nothing to run and must block
+        // (a spinning wait would burn about as much CPU time as the task takes)
+        ThreadPool pool(2);
+        ThreadPool::TaskGroup group;
+        std::clock_t cpuStart = std::clock();
+        pool.run(group, [] { std::this_thread::sleep_for(std::chrono::milliseconds(300)); });
+        pool.wait(group);
+        double cpuMs = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        CHECK(cpuMs < 100);
+
+        // A worker waiting for nested work runs it or sleeps, and never deadlocks
+        ThreadPool::TaskGroup outer;
+        std::atomic<int> inner(0);
+        for (int i = 0; i < 4; ++i)
+        {
+            pool.run(outer, [&pool, &inner]
+                     {
+                         ThreadPool::TaskGroup nested;
+                         for (int j = 0; j < 8; ++j)
+                             pool.run(nested, [&inner]
+                                      { std::this_thread::sleep_for(std::chrono::milliseconds(1)); ++inner; });
+                         pool.wait(nested);
+                     });
+        }
+        pool.wait(outer);
+        CHECK(inner == 32);
+    }
+}
+
+TEST_CASE("Level-synchronous parallel BFS")
+{
+    // Wide tree: root with 40 children, each with 40 children (1 + 40 + 1600 nodes)
+    Tree<int, 40> tree;
+    Node<int> *r = tree.emplace_root(0);
+    int next = 1;
+    std::vector<Node<int> *> middle;
+    for (int i = 0; i < 40; ++i)
+        middle.push_back(tree.emplace_child(r, next++));
+    for (Node<int> *m : middle)
+    {
+        for (int i = 0; i < 40; ++i)
+            tree.emplace_child(m, next++);
+    }
+
+    std::vector<int> bfs;
+    tree.for_each_bfs([&](int value) { bfs.push_back(value); });
+
+    SUBCASE("Levels come in BFS order and every node is visited once")
+    {
+        for (size_t grain : {size_t(1), size_t(7), size_t(100), PARALLEL_GRAIN})
+        {
+            ThreadPool pool(3);
+            std::atomic<long> sum(0);
+            std::vector<int> levels;
+            std::vector<size_t> depths;
+            tree.parallel_bfs([&](int value) { sum += value; },
+                              [&](size_t depth, std::span<Node<int> *const> nodes)
+                              {
+                                  // Every node of the level was visited already
+                                  depths.push_back(depth);
+                                  for (Node<int> *node : nodes)
+                                      levels.push_back(node->value);
+                              },
+                              grain, pool);
+            CHECK(sum == static_cast<long>(next - 1) * next / 2);
+            CHECK(levels == bfs);
+            CHECK(depths == std::vector<size_t>{0, 1, 2});
+        }
+    }
+
+    SUBCASE("Level callbacks run after the level's visits")
+    {
+        ThreadPool pool(2);
+        std::atomic<int> visited(0);
+        std::vector<int> visitedAtLevelEnd;
+        tree.parallel_bfs([&](int &value) { value += 1; ++visited; },
+                          [&](size_t, std::span<Node<int> *const> nodes)
+                          {
+                              visitedAtLevelEnd.push_back(visited);
+                              CHECK(nodes.back()->value == static_cast<int>(visited));
+                          },
+                          16, pool);
+        CHECK(visitedAtLevelEnd == std::vector<int>{1, 41, 1641});
+    }
+
+    SUBCASE("Frontiers come from the tree's memory resource")
+    {
+        SharedCountingResource counter;
+        Tree<int, 4> local(&counter);
+        std::vector<Node<int> *> nodes{local.emplace_root(1)};
+        for (int i = 2; i <= 500; ++i)
+            nodes.push_back(local.emplace_child(nodes[(i - 2) / 4], i));
+
+        ThreadPool pool(2);
+        size_t before = counter.allocations;
+        std::atomic<long> sum(0);
+        local.parallel_bfs([&](int value) { sum += value; }, [](size_t, std::span<Node<int> *const>) {}, 8, pool);
+        CHECK(sum == 500L * 501 / 2);
+        CHECK(counter.allocations > before);
+    }
+
+    SUBCASE("Errors")
+    {
+        ThreadPool pool(2);
+        auto noLevel = [](size_t, std::span<Node<int> *const>) {};
+        CHECK_THROWS_AS(tree.parallel_bfs([](int) {}, noLevel, 0, pool), std::invalid_argument);
+        CHECK_THROWS_AS(tree.parallel_bfs([](int value)
+                                          { if (value == 1000) throw std::runtime_error("stop"); }, noLevel, 8, pool),
+                        std::runtime_error);
+        int levels = 0;
+        CHECK_THROWS_AS(tree.parallel_bfs([](int) {}, [&](size_t depth, std::span<Node<int> *const>)
+                                          { ++levels; if (depth == 1) throw std::runtime_error("level"); }, 8, pool),
+                        std::runtime_error);
+        CHECK(levels == 2);
+
+        Tree<int> empty;
+        empty.parallel_bfs([](int) {}, [&](size_t, std::span<Node<int> *const>) { ++levels; });
+        CHECK(levels == 2);
+    }
+}
+
+TEST_CASE("Parallel reduce")
+{
+    // 1 has the children 2, 3, 4; 2 has 5 and 6; 4 has 7
+    Tree<int, 3> tree;
+    Node<int> *r = tree.emplace_root(1);
+    Node<int> *a = tree.emplace_child(r, 2);
+    tree.emplace_child(r, 3);
+    Node<int> *c = tree.emplace_child(r, 4);
+    tree.emplace_child(a, 5);
+    tree.emplace_child(a, 6);
+    tree.emplace_child(c, 7);
+
+    auto plus = [](long x, long y) { return x + y; };
+    auto value = [](int v) { return static_cast<long>(v); };
+
+    SUBCASE("Root result and subtree aggregates in BFS order")
+    {
+        std::vector<long> sums;
+        CHECK(tree.reduce(0L, value, plus, &sums) == 28);
+        CHECK(sums == std::vector<long>{28, 13, 3, 11, 5, 6, 7});
+
+        std::vector<size_t> sizes;
+        CHECK(tree.reduce(size_t(0), [](int) { return size_t(1); }, [](size_t x, size_t y) { return x + y; }, &sizes) == 7);
+        CHECK(sizes == std::vector<size_t>{7, 3, 1, 2, 1, 1, 1});
+
+        auto larger = [](int x, int y) { return std::max(x, y); };
+        CHECK(tree.reduce(INT_MIN, [](int v) { return v; }, larger) == 7);
+    }
+
+    SUBCASE("Children are combined in order")
+    {
+        // Concatenation is not commutative: the result spells the pre-order
+        auto join = [](const std::string &x, const std::string &y) { return x.empty() ? y : x + " " + y; };
+        std::vector<std::string> labels;
+        std::string pre = tree.reduce(std::string(), [](int v) { return std::to_string(v); }, join, &labels);
+        CHECK(pre == "1 2 5 6 3 4 7");
+        CHECK(labels[1] == "2 5 6");
+        CHECK(labels[3] == "4 7");
+    }
+
+    SUBCASE("Large tree, any grain and pool size")
+    {
+        const int n = 30000;
+        Tree<int, 3> big;
+        std::vector<Node<int> *> open{big.emplace_root(1)};
+        std::mt19937 rng(4);
+        for (int i = 2; i <= n; ++i)
+        {
+            size_t pick = rng() % open.size();
+            Node<int> *parent = open[pick];
+            open.push_back(big.emplace_child(parent, i));
+            if (parent->children.size() == 3)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+
+        // Serial reference: nodes in BFS order, subtree sums from the last one back
+        std::vector<Node<int> *> bfsNodes{big.get_root()};
+        for (size_t i = 0; i < bfsNodes.size(); ++i)
+            bfsNodes.insert(bfsNodes.end(), bfsNodes[i]->children.begin(), bfsNodes[i]->children.end());
+        std::map<Node<int> *, long> subtree;
+        for (size_t i = bfsNodes.size(); i-- > 0;)
+        {
+            long sum = bfsNodes[i]->value;
+            for (Node<int> *child : bfsNodes[i]->children)
+                sum += subtree[child];
+            subtree[bfsNodes[i]] = sum;
+        }
+        std::vector<long> bfsExpected;
+        for (Node<int> *node : bfsNodes)
+            bfsExpected.push_back(subtree[node]);
+
+        for (size_t threads : {1, 4})
+        {
+            ThreadPool pool(threads);
+            for (size_t grain : {size_t(1), size_t(100), PARALLEL_GRAIN})
+            {
+                std::vector<long> sums;
+                CHECK(big.reduce(0L, value, plus, &sums, grain, pool) == static_cast<long>(n) * (n + 1) / 2);
+                CHECK(sums == bfsExpected);
+            }
+        }
+    }
+
+    SUBCASE("Deep chain")
+    {
+        // Every level is one node wide: reduced serially, one pass each way
+        const int n = 100000;
+        Tree<int, 3> chain;
+        Node<int> *node = chain.emplace_root(1);
+        for (int i = 2; i <= n; ++i)
+            node = chain.emplace_child(node, i);
+
+        ThreadPool pool(2);
+        std::vector<long> sums;
+        CHECK(chain.reduce(0L, value, plus, &sums, 16, pool) == static_cast<long>(n) * (n + 1) / 2);
+        REQUIRE(sums.size() == static_cast<size_t>(n));
+        CHECK(sums[n - 1] == n);
+        CHECK(sums[n - 2] == 2L * n - 1);
+
+        // A wide level under the chain goes back to the pool
+        for (int i = 0; i < 3; ++i)
+        {
+            Node<int> *child = chain.emplace_child(node, 0);
+            for (int j = 0; j < 3; ++j)
+                chain.emplace_child(child, 1);
+        }
+        CHECK(chain.reduce(0L, value, plus, nullptr, 2, pool) == static_cast<long>(n) * (n + 1) / 2 + 9);
+    }
+
+    SUBCASE("Scratch space comes from the tree's memory resource")
+    {
+        // Complete binary tree of 5 levels: reduce keeps the nodes in BFS order, the
+        // child offsets and the partial results, all from the tree's resource
+        SharedCountingResource counter;
+        Tree<int> local(&counter);
+        std::vector<Node<int> *> nodes{local.emplace_root(1)};
+        for (int i = 2; i <= 31; ++i)
+            nodes.push_back(local.emplace_child(nodes[(i - 2) / 2], i));
+
+        ThreadPool pool(2);
+        size_t before = counter.allocations;
+        CHECK(local.reduce(0L, value, plus, nullptr, 4, pool) == 31L * 32 / 2);
+        CHECK(counter.allocations - before >= 3 * 5);
+    }
+
+    SUBCASE("Empty trees and errors")
+    {
+        Tree<int> empty;
+        std::vector<long> sums{1, 2};
+        CHECK(empty.reduce(-1L, value, plus, &sums) == -1);
+        CHECK(sums.empty());
+
+        ThreadPool pool(2);
+        CHECK_THROWS_AS(tree.reduce(0L, value, plus, nullptr, 0, pool), std::invalid_argument);
+        CHECK_THROWS_AS(tree.reduce(0L, [](int v) -> long { if (v == 6) throw std::runtime_error("leaf"); return v; },
+                                    plus, nullptr, 1, pool),
+                        std::runtime_error);
+    }
+}
+
+TEST_CASE("Concurrent tree with epoch-based reclamation")
+{
+    SUBCASE("Single-threaded behaviour matches Tree")
+    {
+        ConcurrentTree<int, 3> tree;
+        ConcurrentNode<int> *r = tree.emplace_root(1);
+        ConcurrentNode<int> *a = tree.emplace_child(r, 2);
+        tree.emplace_child(r, 3);
+        tree.emplace_child(a, 4);
+        tree.emplace_child(a, 5);
+        tree.emplace_child(r, 6);
+        CHECK_THROWS_AS(tree.emplace_child(r, 7), std::overflow_error);
+
+        std::vector<int> pre, post, bfs;
+        for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it)
+            pre.push_back(*it);
+        for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it)
+            post.push_back(*it);
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+            bfs.push_back(*it);
+        CHECK(pre == std::vector<int>{1, 2, 4, 5, 3, 6});
+        CHECK(post == std::vector<int>{4, 5, 2, 3, 6, 1});
+        CHECK(bfs == std::vector<int>{1, 2, 3, 6, 4, 5});
+
+        std::vector<int> reverse;
+        for (auto it = r->children.rbegin(); it != r->children.rend(); ++it)
+            reverse.push_back((*it)->value);
+        CHECK(reverse == std::vector<int>{6, 3, 2});
+    }
+
+    SUBCASE("Iterators keep the block they started on")
+    {
+        ConcurrentNode<int> parent(0), x(1), y(2);
+        parent.add_child(&x);
+        parent.add_child(&y);
+        EpochDomain::shared().reclaim(); // No reader announced: the old block is freed
+        CHECK(parent.children.size() == 2);
+        CHECK(parent.children[0] == &x);
+
+        EpochGuard guard;
+        auto first = parent.children.begin();
+        ConcurrentNode<int> z(3);
+        parent.add_child(&z);
+        size_t before = EpochDomain::shared().pending();
+        EpochDomain::shared().reclaim();
+        CHECK(EpochDomain::shared().pending() == before); // Still visible to this reader
+        std::vector<int> seen;
+        for (; first != parent.children.end(); ++first)
+            seen.push_back((*first)->value);
+        CHECK(seen == std::vector<int>{1, 2});
+    }
+
+    SUBCASE("Retired blocks wait for the readers that may see them")
+    {
+        EpochDomain domain;
+        std::pmr::memory_resource *res = std::pmr::get_default_resource();
+        void *early = res->allocate(16);
+        void *late = res->allocate(16);
+        {
+            EpochGuard reader(domain);
+            domain.retire(early, 16, alignof(std::max_align_t), res);
+            CHECK(domain.reclaim() == 0);
+            CHECK(domain.pending() == 1);
+
+            // A reader arriving after the retire cannot see the block
+            EpochGuard later(domain);
+            domain.retire(late, 16, alignof(std::max_align_t), res);
+            CHECK(domain.reclaim() == 0);
+        }
+        CHECK(domain.reclaim() == 2);
+        CHECK(domain.pending() == 0);
+    }
+
+    SUBCASE("Readers scan while a writer grows the tree")
+    {
+        const int total = 20000;
+        ConcurrentTree<int, 8> tree;
+        tree.emplace_root(0);
+        std::atomic<bool> done(false);
+        std::atomic<long> scans(0);
+        std::atomic<int> errors(0);
+
+        auto reader = [&]()
+        {
+            size_t lastCount = 0;
+            while (!done.load())
+            {
+                EpochGuard guard;
+                size_t count = 0;
+                for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it)
+                {
+                    if (*it < 0 || *it >= total)
+                        ++errors;
+                    ++count;
+                }
+                long sum = 0;
+                tree.for_each_post_order([&sum](int value) { sum += value; });
+                if (count < lastCount || sum < 0)
+                    ++errors;
+                lastCount = count;
+                ++scans;
+            }
+        };
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i)
+            readers.emplace_back(reader);
+
+        std::mt19937 rng(8);
+        std::vector<ConcurrentNode<int> *> open{tree.get_root()};
+        for (int i = 1; i < total; ++i)
+        {
+            size_t pick = rng() % open.size();
+            ConcurrentNode<int> *parent = open[pick];
+            open.push_back(tree.emplace_child(parent, i));
+            if (parent->children.size() == 8)
+            {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+        }
+        done = true;
+        for (auto &thread : readers)
+            thread.join();
+
+        CHECK(errors == 0);
+        CHECK(scans > 0);
+        long sum = 0;
+        tree.for_each_bfs([&sum](int value) { sum += value; });
+        CHECK(sum == static_cast<long>(total - 1) * total / 2);
+        EpochDomain::shared().reclaim();
+        CHECK(EpochDomain::shared().pending() == 0);
+    }
+}